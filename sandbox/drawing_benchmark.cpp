@@ -0,0 +1,228 @@
+#include "core/log.h"
+#include "drawing/component_wrappers.h"
+#include "drawing/hit_testing.h"
+#include "drawing/spatial_index.h"
+
+#include <opencv2/imgproc.hpp>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace medicimage;
+
+// the hot paths of the annotation editing on synthetic sheets, the average time per operation is printed
+
+template<typename Func>
+static double MeasureMicroseconds(int iterations, Func&& func)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < iterations; i++)
+    func(i);
+  const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+static void Report(const char* name, double microseconds)
+{
+  std::cout << name << ": " << microseconds << " us" << std::endl;
+}
+
+static void FillSheet(entt::registry& registry, int entityCount, std::mt19937& rng)
+{
+  std::uniform_real_distribution<float> position(0.0f, 0.97f);
+  std::uniform_real_distribution<float> size(0.005f, 0.03f);
+  for(int i = 0; i < entityCount; i++)
+  {
+    const glm::vec2 first{position(rng), position(rng)};
+    const glm::vec2 second = first + glm::vec2{size(rng), size(rng)};
+    switch(i % 4)
+    {
+      case 0: RectangleComponentWrapper(RectangleComponentWrapper::CreateRectangle(registry, first, second, DrawObjectType::PERMANENT)).UpdateShapeAttributes(); break;
+      case 1: CircleComponentWrapper(CircleComponentWrapper::CreateCircle(registry, first, second, 1.0f, DrawObjectType::PERMANENT)).UpdateShapeAttributes(); break;
+      case 2: ArrowComponentWrapper(ArrowComponentWrapper::CreateArrow(registry, first, second, DrawObjectType::PERMANENT)).UpdateShapeAttributes(); break;
+      case 3: LineComponentWrapper(LineComponentWrapper::CreateLine(registry, first, second, DrawObjectType::PERMANENT)).UpdateShapeAttributes(); break;
+    }
+  }
+}
+
+// the hit tests as they were before the spatial index: every entity is visited and its contour is copied into an OpenCV polygon
+static std::vector<glm::vec2> GetTranslatedContour(entt::registry& registry, entt::entity e)
+{
+  const auto& bounds = registry.get<BoundingContourComponent>(e);
+  std::vector<glm::vec2> contour(bounds.cornerPoints.begin(), bounds.cornerPoints.begin() + bounds.pointCount);
+  for(auto& c : contour)
+    c += registry.get<TransformComponent>(e).translation;
+  return contour;
+}
+
+static std::optional<entt::entity> LinearScanHover(entt::registry& registry, glm::vec2 pos)
+{
+  for(auto e : registry.view<BoundingContourComponent>())
+  {
+    auto boundingContour = GetTranslatedContour(registry, e);
+    if(boundingContour.empty())
+      continue;
+    std::vector<cv::Point2f> contour;
+    std::transform(boundingContour.begin(), boundingContour.end(), std::back_inserter(contour), [](glm::vec2 vec) {return cv::Point2f{ vec.x, vec.y }; });
+    if(cv::pointPolygonTest(contour, cv::Point2f{pos.x, pos.y}, false) >= 0)
+      return e;
+  }
+  return {};
+}
+
+static size_t LinearScanBoxSelect(entt::registry& registry, glm::vec2 first, glm::vec2 second)
+{
+  size_t selected = 0;
+  for(auto e : registry.view<BoundingContourComponent>())
+  {
+    auto boundingContour = GetTranslatedContour(registry, e);
+    if(boundingContour.empty())
+      continue;
+    std::vector<cv::Point2f> entityContour;
+    std::transform(boundingContour.begin(), boundingContour.end(), std::back_inserter(entityContour), [](glm::vec2 vec) {return cv::Point2f{ vec.x, vec.y }; });
+    std::vector<cv::Point2f> selectContour{cv::Point2f{first.x, first.y}, cv::Point2f{second.x, first.y},
+      cv::Point2f{second.x, second.y}, cv::Point2f{first.x, second.y}};
+    std::vector<cv::Point2f> tmp;
+    if(cv::intersectConvexConvex(selectContour, entityContour, tmp, true) > 0.0 && cv::intersectConvexConvex(selectContour, entityContour, tmp, false) == 0.0)
+      selected++;
+  }
+  return selected;
+}
+
+static void BenchmarkHitTesting()
+{
+  constexpr int s_entityCount = 10000;
+  constexpr int s_queryCount = 1000;
+  std::mt19937 rng(42);
+  entt::registry registry;
+  SpatialIndex spatialIndex;
+  spatialIndex.Connect(registry);
+  FillSheet(registry, s_entityCount, rng);
+
+  std::uniform_real_distribution<float> position(0.0f, 1.0f);
+  std::vector<glm::vec2> points(s_queryCount);
+  for(auto& p : points)
+    p = {position(rng), position(rng)};
+
+  std::cout << "hit testing, " << s_entityCount << " entities" << std::endl;
+  size_t hovered = 0;
+  Report("hover, linear scan", MeasureMicroseconds(s_queryCount, [&](int i) {
+    hovered += LinearScanHover(registry, points[i]).has_value();
+  }));
+  size_t hoveredIndexed = 0;
+  Report("hover, spatial index", MeasureMicroseconds(s_queryCount, [&](int i) {
+    for(auto e : spatialIndex.QueryPoint(points[i]))
+    {
+      if(HitTesting::IsUnderPoint(Entity(e, &registry), points[i]))
+      {
+        hoveredIndexed++;
+        break;
+      }
+    }
+  }));
+  // the analytic tests follow the shapes more closely than the bounding contours, so the counts can differ slightly
+  std::cout << "hovered: " << hovered << " / " << hoveredIndexed << std::endl;
+
+  // every select box covers a sixteenth of the sheet
+  constexpr int s_selectCount = 100;
+  size_t selected = 0;
+  Report("box select, linear scan", MeasureMicroseconds(s_selectCount, [&](int i) {
+    const glm::vec2 first = points[i] * 0.75f;
+    selected += LinearScanBoxSelect(registry, first, first + 0.25f);
+  }));
+  size_t selectedIndexed = 0;
+  Report("box select, spatial index", MeasureMicroseconds(s_selectCount, [&](int i) {
+    const glm::vec2 first = points[i] * 0.75f;
+    for(auto e : spatialIndex.QueryContained(first, first + 0.25f))
+      selectedIndexed += HitTesting::IsInsideArea(Entity(e, &registry), first, first + 0.25f);
+  }));
+  std::cout << "selected: " << selected << " / " << selectedIndexed << std::endl;
+}
+
+// the begin point of a line or an arrow can be dragged away from its translation, the hover near it has to hit the shape
+template<typename Wrapper>
+static void CheckMovedBeginPoint(const char* name, entt::registry& registry, const SpatialIndex& spatialIndex, Entity entity)
+{
+  Wrapper wrapper(entity);
+  wrapper.UpdateShapeAttributes();
+  wrapper.OnPickPointDrag({-0.2f, -0.1f}, 0);
+  const glm::vec2 pos = entity.GetComponent<TransformComponent>().translation + glm::vec2{-0.19f, -0.095f};
+  const auto candidates = spatialIndex.QueryPoint(pos);
+  const bool hovered = std::any_of(candidates.begin(), candidates.end(), [&](entt::entity e) {
+    return HitTesting::IsUnderPoint(Entity(e, &registry), pos);
+  });
+  std::cout << name << " hovered near its moved begin point: " << (hovered ? "yes" : "no") << std::endl;
+}
+
+static void CheckMovedBeginPoints()
+{
+  entt::registry registry;
+  SpatialIndex spatialIndex;
+  spatialIndex.Connect(registry);
+  CheckMovedBeginPoint<LineComponentWrapper>("line", registry, spatialIndex,
+    LineComponentWrapper::CreateLine(registry, {0.5f, 0.5f}, {0.7f, 0.6f}, DrawObjectType::PERMANENT));
+  CheckMovedBeginPoint<ArrowComponentWrapper>("arrow", registry, spatialIndex,
+    ArrowComponentWrapper::CreateArrow(registry, {0.5f, 0.2f}, {0.7f, 0.3f}, DrawObjectType::PERMANENT));
+}
+
+// a template over most of the sheet with as many slices as the attribute editor allows
+static Entity CreateDenseSkinTemplate(entt::registry& registry)
+{
+  auto entity = SkinTemplateComponentWrapper::CreateSkinTemplate(registry, {0.05f, 0.05f}, {0.95f, 0.95f}, DrawObjectType::PERMANENT);
+  SkinTemplateComponentWrapper skinTemplate(entity);
+  auto& component = entity.GetComponent<SkinTemplateComponent>();
+  component.vertSliceCount = skinTemplate.GetVerticalSliceCountBounds().y;
+  component.leftHorSliceCount = skinTemplate.GetLeftHorizontalSliceCountBounds().y;
+  component.rightHorSliceCount = skinTemplate.GetRightHorizontalSliceCountBounds().y;
+  component.drawSpline = true;
+  skinTemplate.UpdateShapeAttributes();
+  return entity;
+}
+
+static void BenchmarkSkinTemplateDrag()
+{
+  constexpr int s_dragSteps = 1000;
+  entt::registry registry;
+  SpatialIndex spatialIndex;
+  spatialIndex.Connect(registry);
+  auto entity = CreateDenseSkinTemplate(registry);
+  SkinTemplateComponentWrapper skinTemplate(entity);
+
+  const auto& component = entity.GetComponent<SkinTemplateComponent>();
+  const size_t sliceCount = component.verticalSlices.size() + component.leftHorizontalSlices.size() + component.rightHorizontalSlices.size();
+  std::cout << "skin template drag, " << sliceCount << " slices" << std::endl;
+  // the steps go back and forth, so the template keeps its size and its slice counts
+  auto step = [](int i) { return glm::vec2{i % 2 == 0 ? 0.001f : -0.001f, 0.0f}; };
+  Report("object drag", MeasureMicroseconds(s_dragSteps, [&](int i) {
+    skinTemplate.OnObjectDrag(step(i));
+  }));
+  Report("pickpoint drag, right side", MeasureMicroseconds(s_dragSteps, [&](int i) {
+    skinTemplate.OnPickPointDrag(step(i), static_cast<int>(SkinTemplatePickPoints::RIGHT));
+  }));
+  // every slice destroyed and created again on every step, as it was before the slices were updated in place
+  Report("object drag, slices recreated", MeasureMicroseconds(s_dragSteps, [&](int i) {
+    skinTemplate.DestroySlices();
+    entity.GetComponent<SkinTemplateComponent>().drawable = true;
+    skinTemplate.OnObjectDrag(step(i));
+  }));
+  // the preview while the template is being drawn, it has the default slice counts
+  Report("preview drag", MeasureMicroseconds(s_dragSteps, [&](int i) {
+    skinTemplate.SetPoints({0.05f, 0.05f}, glm::vec2{0.95f, 0.95f} + step(i));
+    skinTemplate.UpdateShapeAttributes();
+  }));
+}
+
+int main(int, char**)
+{
+  Logger::Init();
+  BenchmarkHitTesting();
+  CheckMovedBeginPoints();
+  BenchmarkSkinTemplateDrag();
+  return 0;
+}
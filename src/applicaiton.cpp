@@ -17,10 +17,7 @@ Application::Application()
 }
 
 Application::~Application()
-{
-  for(auto event : m_inputHandler->GetCollectedEvents())
-    delete event;
-}
+{}
 
 void Application::OnEvent(Event* e)
 {
@@ -74,8 +71,7 @@ void Application::Run()
 
     // event handling for every frame
     m_inputHandler->PollEvents();
-    auto events = m_inputHandler->GetCollectedEvents();
-    for(auto event : events)
+    for(auto event : m_inputHandler->GetCollectedEvents())
     {
       OnEvent(event);
       m_editor.OnEvent(event);
@@ -91,6 +87,7 @@ void Application::Run()
     m_imguiLayer->End();
 
     renderer.SwapBuffers(); // TODO: this should be integrated into m_window->OnUpdate ??? idk..
+    m_editor.OnFramePresented();
     //m_window->OnUpdate(); 
   }
 }
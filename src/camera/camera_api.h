@@ -1,7 +1,16 @@
 #pragma once
 #include "renderer/texture.h"
+#include "camera/frame_ring_buffer.h"
+#include "camera/undistortion.h"
+#include "camera/image_pipeline.h"
 
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 namespace medicimage
 {
@@ -9,15 +18,21 @@ namespace medicimage
 // Simple camera interface, one thing is sure: we need the feed in DirectX texture on the GPU
 class CameraAPI
 {
-public:
-  using Frame = std::optional<std::unique_ptr<Texture2D>>;  
 public:
   CameraAPI() = default;
   ~CameraAPI(){}
   virtual void Init() = 0; // TODO: think about the error handling
   virtual void Open(int index) = 0;
   bool IsOpened(){ return m_opened; }
-  virtual Frame CaptureFrame() = 0;
+  // preview stream: uploads the newest preview frame into the texture, which is only recreated when the size changes.
+  // Returns false when there is no new frame since the last call
+  virtual bool UpdatePreview(std::unique_ptr<Texture2D>& preview) = 0;
+  // the preview frames are downscaled to this size in the capture thread, but never upscaled above the camera resolution
+  void SetPreviewSize(int width, int height)
+  {
+    m_previewWidth = width;
+    m_previewHeight = height;
+  }
   virtual void Close() = 0;
   int GetNumberOfDevices() {return m_numberOfDevices;}
   virtual std::string GetDeviceName(int index) = 0;
@@ -27,10 +42,60 @@ public:
     else
       return std::nullopt;
   }
+  double GetFrameRate() const {return m_frameRate;}
+  // still stream: most recent frame in full sensor resolution and BGR format, as it came from the camera, it is never uploaded
+  std::optional<cv::Mat> GetLatestStill() {return m_stillFrames.CopyLatest();}
+  // moves out the last count frames of the still buffer for the burst capture, ordered from the oldest
+  std::vector<cv::Mat> TakeRecentStills(size_t count) {return m_stillFrames.TakeLatest(count);}
+  size_t GetStillBufferCapacity() const {return m_stillFrames.GetCapacity();}
+  // lens correction applied on the raw frames, so both the preview and the stills are corrected
+  Undistortion& GetUndistortion() {return m_undistortion;}
+  // enhancement stages of the live feed, the stages and the parameters can be changed from the UI thread
+  ImagePipeline& GetImagePipeline() {return m_imagePipeline;}
+  // called on the capture thread with every raw frame, e.g. for recording, so it must not block
+  using RawFrameCallback = std::function<void(const cv::Mat&)>;
+  void SetRawFrameCallback(const RawFrameCallback& callback)
+  {
+    std::scoped_lock lock(m_rawFrameCallbackMutex);
+    m_rawFrameCallback = callback;
+  }
+protected:
+  // every acquired frame gets the next sequence number, so the gaps show the dropped frames
+  FrameTimestamps NextFrameTimestamps()
+  {
+    FrameTimestamps timestamps;
+    timestamps.sequence = ++m_frameSequence;
+    timestamps.captured = FrameClock::now();
+    return timestamps;
+  }
+  void NotifyRawFrame(const cv::Mat& frame)
+  {
+    std::scoped_lock lock(m_rawFrameCallbackMutex);
+    if(m_rawFrameCallback)
+      m_rawFrameCallback(frame);
+  }
+  cv::Size GetPreviewSize(cv::Size frameSize) const
+  {
+    const int width = m_previewWidth;
+    const int height = m_previewHeight;
+    if(width <= 0 || height <= 0)
+      return frameSize;
+    return cv::Size(std::min(width, frameSize.width), std::min(height, frameSize.height));
+  }
 protected:
-  bool m_opened = false;
-  int m_selectedDevice = -1;
+  // written by the thread (re)opening the device, read by the UI
+  std::atomic<bool> m_opened = false;
+  std::atomic<int> m_selectedDevice = -1;
   int m_numberOfDevices = 0;
+  std::atomic<double> m_frameRate = 30.0;
+  uint64_t m_frameSequence = 0;
+  FrameRingBuffer m_stillFrames; // the last frames in full sensor resolution
+  Undistortion m_undistortion;
+  ImagePipeline m_imagePipeline; // used only by the capture thread for processing
+  std::atomic<int> m_previewWidth = 0;
+  std::atomic<int> m_previewHeight = 0;
+  std::mutex m_rawFrameCallbackMutex;
+  RawFrameCallback m_rawFrameCallback;
 
 };
 
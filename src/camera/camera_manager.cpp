@@ -0,0 +1,168 @@
+#include "camera/camera_manager.h"
+#include "core/log.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cctype>
+
+namespace medicimage
+{
+
+void CameraManager::Init()
+{
+  m_deviceMonitor.Stop();
+  CloseAll();
+  m_cameras.clear();
+  m_primary.reset();
+  // the devices are probed only once, probing opens every one of them
+  m_deviceNames = OpenCvCamera::EnumerateDevices();
+  for(size_t i = 0; i < m_deviceNames.size(); i++)
+    m_cameras.push_back(std::make_unique<OpenCvCamera>(m_deviceNames));
+}
+
+void CameraManager::Open(int index)
+{
+  assert(index < GetNumberOfDevices() && "Camera ID is out of range!");
+  auto& camera = *m_cameras[index];
+  camera.Open(index);
+  if(camera.IsOpened() && !m_calibrationFolder.empty())
+  {
+    auto calibrationFile = GetCalibrationFile(camera, index);
+    if(std::filesystem::exists(calibrationFile))
+      camera.GetUndistortion().SetEnabled(camera.GetUndistortion().LoadCalibration(calibrationFile));
+  }
+  if(camera.IsOpened() && !m_primary.has_value())
+    SetPrimary(index);
+}
+
+std::filesystem::path CameraManager::GetCalibrationFile(OpenCvCamera& camera, int index) const
+{
+  // the calibration belongs to the physical camera, not to its enumeration slot, so the file is named after the device id;
+  // the cameras without a device path (e.g. the virtual ones) fall back to their enumerated name
+  std::string name = camera.GetDeviceId();
+  if(name.empty())
+    return m_calibrationFolder / (m_deviceNames[index] + ".json");
+  std::replace_if(name.begin(), name.end(), [](unsigned char c) { return !std::isalnum(c); }, '_');
+  return m_calibrationFolder / (name + ".json");
+}
+
+void CameraManager::Close(int index)
+{
+  assert(index < GetNumberOfDevices() && "Camera ID is out of range!");
+  m_cameras[index]->Close();
+  if(m_primary == index)
+  {
+    m_cameras[index]->SetRawFrameCallback(nullptr);
+    m_primary.reset();
+    // fall back to another opened camera, if there is any
+    auto secondaries = GetSecondaryCameras();
+    if(!secondaries.empty())
+      SetPrimary(secondaries.front());
+  }
+}
+
+void CameraManager::CloseAll()
+{
+  for(auto& camera : m_cameras)
+  {
+    camera->SetRawFrameCallback(nullptr);
+    camera->Close();
+  }
+  m_primary.reset();
+}
+
+bool CameraManager::IsOpened(int index)
+{
+  return index >= 0 && index < GetNumberOfDevices() && m_cameras[index]->IsOpened();
+}
+
+std::string CameraManager::GetDeviceName(int index) const
+{
+  return m_deviceNames[index];
+}
+
+void CameraManager::SetPrimary(int index)
+{
+  if(!IsOpened(index))
+  {
+    APP_CORE_WARN("Camera:{} is not opened, it cannot be the primary camera", index);
+    return;
+  }
+  if(m_primary.has_value())
+    m_cameras[m_primary.value()]->SetRawFrameCallback(nullptr);
+  m_primary = index;
+  m_cameras[index]->SetRawFrameCallback(m_primaryRawFrameCallback);
+  APP_CORE_INFO("Primary camera:{}", m_deviceNames[index]);
+}
+
+OpenCvCamera& CameraManager::GetPrimary()
+{
+  if(m_primary.has_value())
+    return *m_cameras[m_primary.value()];
+  return m_noCamera;
+}
+
+OpenCvCamera& CameraManager::GetCamera(int index)
+{
+  assert(index < GetNumberOfDevices() && "Camera ID is out of range!");
+  return *m_cameras[index];
+}
+
+std::vector<int> CameraManager::GetSecondaryCameras()
+{
+  std::vector<int> secondaries;
+  for(int i = 0; i < GetNumberOfDevices(); i++)
+  {
+    if(m_cameras[i]->IsOpened() && m_primary != i)
+      secondaries.push_back(i);
+  }
+  return secondaries;
+}
+
+void CameraManager::SetPrimaryRawFrameCallback(const CameraAPI::RawFrameCallback& callback)
+{
+  m_primaryRawFrameCallback = callback;
+  if(m_primary.has_value())
+    m_cameras[m_primary.value()]->SetRawFrameCallback(m_primaryRawFrameCallback);
+}
+
+void CameraManager::StartHotPlugMonitor()
+{
+  m_deviceMonitor.Start([this](const DeviceMonitor::Changes& changes){ OnDevicesChanged(changes); });
+}
+
+void CameraManager::OnDevicesChanged(const DeviceMonitor::Changes& changes)
+{
+  // runs on the monitor thread, so the reopening does not stall the UI
+  for(const auto& device : changes.removed)
+    APP_CORE_WARN("Video device removed:{}", device);
+  for(const auto& device : changes.arrived)
+    APP_CORE_INFO("Video device arrived:{}", device);
+  if(changes.arrived.empty())
+    return;
+
+  // only the cameras whose own device arrived are reopened
+  std::vector<std::string> arrivedIds;
+  for(const auto& device : changes.arrived)
+    arrivedIds.push_back(DeviceMonitor::GetDeviceId(device));
+  auto hasArrived = [&arrivedIds](OpenCvCamera& camera) {
+    return std::find(arrivedIds.begin(), arrivedIds.end(), camera.GetDeviceId()) != arrivedIds.end();
+  };
+
+  // the driver may not be ready right after the arrival, so the reopen is retried a few times
+  for(int attempt = 0; attempt < s_reconnectAttempts; attempt++)
+  {
+    bool reconnectPending = false;
+    for(auto& camera : m_cameras)
+    {
+      if(camera->IsConnectionLost() && hasArrived(*camera) && !camera->Reconnect())
+        reconnectPending = true;
+    }
+    if(!reconnectPending)
+      return;
+    std::this_thread::sleep_for(s_reconnectRetryInterval);
+  }
+  APP_CORE_ERR("Could not reconnect the camera after the device arrived");
+}
+
+} // namespace medicimage
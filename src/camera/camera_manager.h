@@ -0,0 +1,58 @@
+#pragma once
+
+#include "camera/opencv_camera.h"
+#include "camera/device_monitor.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief Owns one camera per attached device, so several of them can capture at the same time. Every camera
+///         runs its own capture thread with its own preview slot, so a slow device does not stall the others.
+///         The primary camera provides the main preview, the stills and the recorded frames
+class CameraManager
+{
+public:
+  CameraManager() = default;
+  void Init();
+  void Open(int index);
+  void Close(int index);
+  void CloseAll();
+  bool IsOpened(int index);
+  int GetNumberOfDevices() const {return static_cast<int>(m_cameras.size());}
+  std::string GetDeviceName(int index) const;
+
+  void SetPrimary(int index);
+  std::optional<int> GetPrimaryIndex() const {return m_primary;}
+  // returns a closed camera when there is no opened device, so the callers do not have to check it
+  OpenCvCamera& GetPrimary();
+  OpenCvCamera& GetCamera(int index);
+  // opened cameras other than the primary one
+  std::vector<int> GetSecondaryCameras();
+  // the callback is always attached to the current primary camera
+  void SetPrimaryRawFrameCallback(const CameraAPI::RawFrameCallback& callback);
+  // watches the unplugged and replugged devices, and reconnects the cameras which lost their device
+  void StartHotPlugMonitor();
+  // the lens calibration of a device is loaded from <folder>/<device id>.json when it is opened, the characters
+  // of the device id other than letters and digits are replaced by '_' (e.g. ____usb_vid_046d_pid_0825_mi_00_7_1a2b3c4d_0_0000)
+  void SetCalibrationFolder(const std::filesystem::path& folder){m_calibrationFolder = folder;}
+private:
+  void OnDevicesChanged(const DeviceMonitor::Changes& changes);
+  std::filesystem::path GetCalibrationFile(OpenCvCamera& camera, int index) const;
+
+  std::vector<std::string> m_deviceNames;
+  std::vector<std::unique_ptr<OpenCvCamera>> m_cameras;
+  OpenCvCamera m_noCamera;
+  std::optional<int> m_primary;
+  std::filesystem::path m_calibrationFolder;
+  CameraAPI::RawFrameCallback m_primaryRawFrameCallback;
+  DeviceMonitor m_deviceMonitor; // declared last, so its thread is stopped before the cameras are destroyed
+  static constexpr int s_reconnectAttempts = 5;
+  static constexpr std::chrono::milliseconds s_reconnectRetryInterval{500};
+};
+
+} // namespace medicimage
@@ -0,0 +1,190 @@
+#include "camera/device_monitor.h"
+#include "core/log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <setupapi.h>
+#include <dshow.h>
+#else
+#include <charconv>
+#include <filesystem>
+#endif
+
+namespace medicimage
+{
+
+#ifdef _WIN32
+// KSCATEGORY_VIDEO_CAMERA, defined here so ksmedia.h and its guid library are not needed
+static constexpr GUID s_videoCameraCategory = {0xe5323777, 0xf976, 0x4f5b, {0x9b, 0x55, 0xb9, 0x46, 0x99, 0xc4, 0x6e, 0x44}};
+
+std::vector<std::string> DeviceMonitor::ListDevices()
+{
+  std::vector<std::string> devices;
+  HDEVINFO deviceInfo = SetupDiGetClassDevsA(&s_videoCameraCategory, nullptr, nullptr, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+  if(deviceInfo == INVALID_HANDLE_VALUE)
+  {
+    APP_CORE_ERR("Could not list the video devices, error:{}", GetLastError());
+    return devices;
+  }
+
+  SP_DEVICE_INTERFACE_DATA interfaceData{};
+  interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+  for(DWORD i = 0; SetupDiEnumDeviceInterfaces(deviceInfo, nullptr, &s_videoCameraCategory, i, &interfaceData); i++)
+  {
+    DWORD detailSize = 0;
+    SetupDiGetDeviceInterfaceDetailA(deviceInfo, &interfaceData, nullptr, 0, &detailSize, nullptr);
+    if(detailSize == 0)
+      continue;
+    std::vector<char> buffer(detailSize);
+    auto* detail = reinterpret_cast<SP_DEVICE_INTERFACE_DETAIL_DATA_A*>(buffer.data());
+    detail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_A);
+    if(SetupDiGetDeviceInterfaceDetailA(deviceInfo, &interfaceData, detail, detailSize, nullptr, nullptr))
+      devices.emplace_back(detail->DevicePath);
+  }
+  SetupDiDestroyDeviceInfoList(deviceInfo);
+  return devices;
+}
+
+std::vector<std::string> DeviceMonitor::ListCaptureDevices()
+{
+  // the DirectShow backend of OpenCV opens the devices in the order of the video input category
+  std::vector<std::string> devices;
+  const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+  ICreateDevEnum* deviceEnum = nullptr;
+  IEnumMoniker* monikers = nullptr;
+  if(SUCCEEDED(CoCreateInstance(CLSID_SystemDeviceEnum, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&deviceEnum))) &&
+    deviceEnum->CreateClassEnumerator(CLSID_VideoInputDeviceCategory, &monikers, 0) == S_OK)
+  {
+    IMoniker* moniker = nullptr;
+    while(monikers->Next(1, &moniker, nullptr) == S_OK)
+    {
+      // virtual cameras have no device path, they keep their place in the order with an empty one
+      std::string path;
+      IPropertyBag* properties = nullptr;
+      if(SUCCEEDED(moniker->BindToStorage(nullptr, nullptr, IID_PPV_ARGS(&properties))))
+      {
+        VARIANT value;
+        VariantInit(&value);
+        if(SUCCEEDED(properties->Read(L"DevicePath", &value, nullptr)) && value.vt == VT_BSTR)
+        {
+          const int size = WideCharToMultiByte(CP_UTF8, 0, value.bstrVal, -1, nullptr, 0, nullptr, nullptr);
+          if(size > 1)
+          {
+            path.resize(size - 1);
+            WideCharToMultiByte(CP_UTF8, 0, value.bstrVal, -1, path.data(), size, nullptr, nullptr);
+          }
+        }
+        VariantClear(&value);
+        properties->Release();
+      }
+      devices.push_back(std::move(path));
+      moniker->Release();
+    }
+  }
+  if(monikers != nullptr)
+    monikers->Release();
+  if(deviceEnum != nullptr)
+    deviceEnum->Release();
+  // a thread already initialized in another apartment mode can still enumerate, but it must not uninitialize
+  if(SUCCEEDED(comResult))
+    CoUninitialize();
+  return devices;
+}
+#else
+std::vector<std::string> DeviceMonitor::ListDevices()
+{
+  // V4L2 devices show up as /dev/videoN
+  std::vector<std::string> devices;
+  std::error_code error;
+  for(const auto& entry : std::filesystem::directory_iterator("/dev", error))
+  {
+    if(entry.path().filename().string().rfind("video", 0) == 0)
+      devices.push_back(entry.path().string());
+  }
+  return devices;
+}
+
+std::vector<std::string> DeviceMonitor::ListCaptureDevices()
+{
+  // the capture index N opens /dev/videoN, the missing numbers are left empty
+  std::vector<std::string> devices;
+  const std::string prefix = "/dev/video";
+  for(const auto& device : ListDevices())
+  {
+    size_t number = 0;
+    auto [end, error] = std::from_chars(device.data() + prefix.size(), device.data() + device.size(), number);
+    if(error != std::errc() || end != device.data() + device.size())
+      continue;
+    if(devices.size() <= number)
+      devices.resize(number + 1);
+    devices[number] = device;
+  }
+  return devices;
+}
+#endif
+
+std::string DeviceMonitor::GetDeviceId(const std::string& path)
+{
+  // \\?\usb#vid_046d&pid_0825&mi_00#7&1a2b3c4d&0&0000#{category guid}\global: the part before the category
+  // is the device instance, the paths are case insensitive
+  std::string id = path.substr(0, path.rfind("#{"));
+  std::transform(id.begin(), id.end(), id.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return id;
+}
+
+DeviceMonitor::~DeviceMonitor()
+{
+  Stop();
+}
+
+void DeviceMonitor::Start(const ChangeCallback& callback)
+{
+  Stop();
+  m_callback = callback;
+  m_stopRequested = false;
+  m_monitorThread = std::thread(&DeviceMonitor::MonitorLoop, this);
+}
+
+void DeviceMonitor::Stop()
+{
+  if(!m_monitorThread.joinable())
+    return;
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stopRequested = true;
+  }
+  m_stopCondition.notify_one();
+  m_monitorThread.join();
+}
+
+void DeviceMonitor::MonitorLoop()
+{
+  auto knownDevices = ListDevices();
+  std::sort(knownDevices.begin(), knownDevices.end());
+  while(true)
+  {
+    {
+      std::unique_lock lock(m_mutex);
+      if(m_stopCondition.wait_for(lock, s_pollInterval, [this]{return m_stopRequested;}))
+        break;
+    }
+
+    auto devices = ListDevices();
+    std::sort(devices.begin(), devices.end());
+    if(devices == knownDevices)
+      continue;
+
+    Changes changes;
+    std::set_difference(devices.begin(), devices.end(), knownDevices.begin(), knownDevices.end(), std::back_inserter(changes.arrived));
+    std::set_difference(knownDevices.begin(), knownDevices.end(), devices.begin(), devices.end(), std::back_inserter(changes.removed));
+    knownDevices = std::move(devices);
+    if(m_callback)
+      m_callback(changes);
+  }
+}
+
+} // namespace medicimage
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief Watches the attached video capture devices on a background thread and reports the arrived and removed ones.
+///         The device list is polled, because the window message loop (and so WM_DEVICECHANGE) is owned by SDL
+class DeviceMonitor
+{
+public:
+  struct Changes
+  {
+    std::vector<std::string> arrived;
+    std::vector<std::string> removed;
+  };
+  using ChangeCallback = std::function<void(const Changes&)>;
+public:
+  DeviceMonitor() = default;
+  ~DeviceMonitor();
+  // the callback is called on the monitor thread
+  void Start(const ChangeCallback& callback);
+  void Stop();
+  // system paths of the present video capture devices
+  static std::vector<std::string> ListDevices();
+  // system paths of the capture devices in the order of their capture indices, as cv::VideoCapture opens them
+  static std::vector<std::string> ListCaptureDevices();
+  // the device instance of a path, a device has a different path in every device interface category it is in
+  static std::string GetDeviceId(const std::string& path);
+private:
+  void MonitorLoop();
+
+  ChangeCallback m_callback;
+  std::thread m_monitorThread;
+  std::mutex m_mutex;
+  std::condition_variable m_stopCondition;
+  bool m_stopRequested = false;
+  static constexpr std::chrono::milliseconds s_pollInterval{500};
+};
+
+} // namespace medicimage
@@ -0,0 +1,70 @@
+#include "camera/frame_ring_buffer.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace medicimage
+{
+
+FrameRingBuffer::FrameRingBuffer(size_t capacity) : m_frames(capacity)
+{
+  assert(capacity > 1 && "The ring buffer needs at least two slots");
+}
+
+cv::Mat& FrameRingBuffer::BeginWrite()
+{
+  std::scoped_lock lock(m_mutex);
+  // the slot under writing is the oldest frame, it is not readable anymore
+  if(m_size == m_frames.size())
+    m_size--;
+  return m_frames[m_head];
+}
+
+void FrameRingBuffer::EndWrite()
+{
+  std::scoped_lock lock(m_mutex);
+  m_head = (m_head + 1) % m_frames.size();
+  m_size = std::min(m_size + 1, m_frames.size());
+}
+
+std::optional<cv::Mat> FrameRingBuffer::CopyLatest() const
+{
+  std::scoped_lock lock(m_mutex);
+  if(m_size == 0)
+    return std::nullopt;
+  const size_t latest = (m_head + m_frames.size() - 1) % m_frames.size();
+  return m_frames[latest].clone();
+}
+
+std::vector<cv::Mat> FrameRingBuffer::TakeLatest(size_t count)
+{
+  std::scoped_lock lock(m_mutex);
+  count = std::min(count, m_size);
+  std::vector<cv::Mat> frames;
+  frames.reserve(count);
+  // no copy here: the headers are moved out, the emptied slots are allocated again by the next writes
+  for(size_t i = count; i > 0; i--)
+  {
+    const size_t index = (m_head + m_frames.size() - i) % m_frames.size();
+    frames.push_back(std::move(m_frames[index]));
+  }
+  m_size = 0;
+  return frames;
+}
+
+void FrameRingBuffer::Clear()
+{
+  std::scoped_lock lock(m_mutex);
+  for(auto& frame : m_frames)
+    frame.release();
+  m_head = 0;
+  m_size = 0;
+}
+
+size_t FrameRingBuffer::GetSize() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_size;
+}
+
+} // namespace medicimage
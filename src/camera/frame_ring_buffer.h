@@ -0,0 +1,36 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief Fixed size ring of camera frames. The slots are reused, so when the resolution does not change
+///         writing a frame into it does not allocate
+class FrameRingBuffer
+{
+public:
+  FrameRingBuffer(size_t capacity = s_defaultCapacity);
+  // returns the slot for the next frame, which has to be filled in place and committed with EndWrite()
+  cv::Mat& BeginWrite();
+  void EndWrite();
+  std::optional<cv::Mat> CopyLatest() const;
+  // moves out the latest count frames ordered from the oldest to the newest, the buffer starts over after it
+  std::vector<cv::Mat> TakeLatest(size_t count);
+  void Clear();
+  size_t GetCapacity() const {return m_frames.size();}
+  size_t GetSize() const;
+
+  static constexpr size_t s_defaultCapacity = 8;
+private:
+  std::vector<cv::Mat> m_frames;
+  size_t m_head = 0; // slot of the next frame
+  size_t m_size = 0; // number of committed frames
+  mutable std::mutex m_mutex;
+};
+
+} // namespace medicimage
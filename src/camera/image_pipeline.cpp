@@ -0,0 +1,127 @@
+#include "camera/image_pipeline.h"
+#include "core/frame_timing.h"
+
+#include <opencv2/photo.hpp>
+
+#include <algorithm>
+
+namespace medicimage
+{
+
+void ImageStage::RecordTiming(double ms)
+{
+  // exponential moving average, only the processing thread writes it
+  constexpr double smoothing = 0.1;
+  m_averageMs = m_averageMs * (1.0 - smoothing) + ms * smoothing;
+}
+
+void WhiteBalanceStage::Process(const cv::Mat& src, cv::Mat& dst)
+{
+  auto params = GetParams();
+  cv::Vec3f gains{params.blueGain, params.greenGain, params.redGain};
+  if(params.automatic)
+  {
+    // gray world assumption: the average of the image should be neutral gray
+    cv::Scalar mean = cv::mean(src);
+    const double gray = (mean[0] + mean[1] + mean[2]) / 3.0;
+    for(int c = 0; c < 3; c++)
+      gains[c] = mean[c] > 1.0 ? static_cast<float>(gray / mean[c]) : 1.0f;
+  }
+
+  // the gains are applied with a lookup table, which is a single pass over the image
+  auto* table = m_lookupTable.ptr<cv::Vec3b>();
+  for(int i = 0; i < 256; i++)
+  {
+    for(int c = 0; c < 3; c++)
+      table[i][c] = cv::saturate_cast<uchar>(i * std::clamp(gains[c], 0.25f, 4.0f));
+  }
+  cv::LUT(src, m_lookupTable, dst);
+}
+
+void GlareSuppressionStage::Process(const cv::Mat& src, cv::Mat& dst)
+{
+  auto params = GetParams();
+  cv::resize(src, m_small, cv::Size(src.cols / s_downscale, src.rows / s_downscale), 0.0, 0.0, cv::INTER_AREA);
+  cv::cvtColor(m_small, m_hsv, cv::COLOR_BGR2HSV);
+  // specular reflections are bright and almost white
+  cv::inRange(m_hsv, cv::Scalar(0, 0, params.threshold), cv::Scalar(180, params.maxSaturation, 255), m_mask);
+  if(m_kernelSize != params.dilation)
+  {
+    m_kernelSize = params.dilation;
+    m_kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * m_kernelSize + 1, 2 * m_kernelSize + 1));
+  }
+  if(m_kernelSize > 0)
+    cv::dilate(m_mask, m_mask, m_kernel);
+
+  src.copyTo(dst);
+  if(cv::countNonZero(m_mask) == 0)
+    return;
+  cv::inpaint(m_small, m_mask, m_inpainted, 3.0, cv::INPAINT_TELEA);
+  cv::resize(m_inpainted, m_inpaintedFull, src.size(), 0.0, 0.0, cv::INTER_LINEAR);
+  cv::resize(m_mask, m_maskFull, src.size(), 0.0, 0.0, cv::INTER_NEAREST);
+  m_inpaintedFull.copyTo(dst, m_maskFull);
+}
+
+void ClaheStage::Process(const cv::Mat& src, cv::Mat& dst)
+{
+  auto params = GetParams();
+  if(m_clahe.empty())
+    m_clahe = cv::createCLAHE();
+  m_clahe->setClipLimit(params.clipLimit);
+  m_clahe->setTilesGridSize(cv::Size(params.tileGridSize, params.tileGridSize));
+
+  // only the lightness is equalized, so the colors of the skin stay the same
+  cv::cvtColor(src, m_lab, cv::COLOR_BGR2Lab);
+  cv::split(m_lab, m_labChannels);
+  m_clahe->apply(m_labChannels[0], m_labChannels[0]);
+  cv::merge(m_labChannels, m_lab);
+  cv::cvtColor(m_lab, dst, cv::COLOR_Lab2BGR);
+}
+
+void SharpenStage::Process(const cv::Mat& src, cv::Mat& dst)
+{
+  auto params = GetParams();
+  // unsharp masking: src + amount * (src - blurred)
+  cv::GaussianBlur(src, m_blurred, cv::Size(0, 0), params.sigma);
+  cv::addWeighted(src, 1.0 + params.amount, m_blurred, -params.amount, 0.0, dst);
+}
+
+ImagePipeline::ImagePipeline()
+{
+  m_stages.push_back(std::make_unique<WhiteBalanceStage>());
+  m_stages.push_back(std::make_unique<GlareSuppressionStage>());
+  m_stages.push_back(std::make_unique<ClaheStage>());
+  m_stages.push_back(std::make_unique<SharpenStage>());
+}
+
+const cv::Mat& ImagePipeline::Process(const cv::Mat& src)
+{
+  const cv::Mat* input = &src;
+  int output = 0;
+  for(auto& stage : m_stages)
+  {
+    if(!stage->IsEnabled())
+      continue;
+    const auto start = FrameClock::now();
+    stage->Process(*input, m_buffers[output]);
+    stage->RecordTiming(std::chrono::duration<double, std::milli>(FrameClock::now() - start).count());
+    input = &m_buffers[output];
+    output ^= 1;
+  }
+  return *input;
+}
+
+std::unique_ptr<ImagePipeline> ImagePipeline::Clone() const
+{
+  std::vector<std::unique_ptr<ImageStage>> stages;
+  for(const auto& stage : m_stages)
+    stages.push_back(stage->Clone());
+  return std::unique_ptr<ImagePipeline>(new ImagePipeline(std::move(stages)));
+}
+
+bool ImagePipeline::HasEnabledStage() const
+{
+  return std::any_of(m_stages.begin(), m_stages.end(), [](const auto& stage){ return stage->IsEnabled(); });
+}
+
+} // namespace medicimage
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief One step of the image enhancement graph. The stages work on 8 bit BGR images and keep their
+///         intermediate buffers between the frames, so the processing does not allocate in steady state
+class ImageStage
+{
+public:
+  ImageStage(const std::string& name) : m_name(name){}
+  virtual ~ImageStage() = default;
+  // dst is a reused buffer of the pipeline, it never aliases src
+  virtual void Process(const cv::Mat& src, cv::Mat& dst) = 0;
+  // copy of the stage with the same parameters, but with its own buffers
+  virtual std::unique_ptr<ImageStage> Clone() const = 0;
+
+  const std::string& GetName() const {return m_name;}
+  bool IsEnabled() const {return m_enabled;}
+  void SetEnabled(bool enabled){m_enabled = enabled;}
+  double GetAverageMs() const {return m_averageMs;}
+  void RecordTiming(double ms);
+private:
+  std::string m_name;
+  std::atomic<bool> m_enabled = false;
+  std::atomic<double> m_averageMs = 0.0;
+};
+
+/// @brief the parameters are set from the UI thread and read by the processing thread at the start of every frame
+template<typename Params>
+class ParameterizedStage : public ImageStage
+{
+public:
+  using ParamsType = Params;
+  ParameterizedStage(const std::string& name) : ImageStage(name){}
+  Params GetParams() const
+  {
+    std::scoped_lock lock(m_paramsMutex);
+    return m_params;
+  }
+  void SetParams(const Params& params)
+  {
+    std::scoped_lock lock(m_paramsMutex);
+    m_params = params;
+  }
+protected:
+  template<typename StageType>
+  std::unique_ptr<ImageStage> CloneAs() const
+  {
+    auto stage = std::make_unique<StageType>();
+    stage->SetParams(GetParams());
+    stage->SetEnabled(IsEnabled());
+    return stage;
+  }
+private:
+  mutable std::mutex m_paramsMutex;
+  Params m_params;
+};
+
+struct WhiteBalanceParams
+{
+  bool automatic = true; // gray world estimation on every frame, otherwise the manual gains are used
+  float redGain = 1.0f;
+  float greenGain = 1.0f;
+  float blueGain = 1.0f;
+};
+
+class WhiteBalanceStage : public ParameterizedStage<WhiteBalanceParams>
+{
+public:
+  WhiteBalanceStage() : ParameterizedStage("White balance"){}
+  void Process(const cv::Mat& src, cv::Mat& dst) override;
+  std::unique_ptr<ImageStage> Clone() const override {return CloneAs<WhiteBalanceStage>();}
+private:
+  cv::Mat m_lookupTable = cv::Mat(1, 256, CV_8UC3);
+};
+
+struct GlareSuppressionParams
+{
+  int threshold = 235; // brightness above which a low saturation pixel counts as specular reflection
+  int maxSaturation = 60;
+  int dilation = 2;
+};
+
+class GlareSuppressionStage : public ParameterizedStage<GlareSuppressionParams>
+{
+public:
+  GlareSuppressionStage() : ParameterizedStage("Glare suppression"){}
+  void Process(const cv::Mat& src, cv::Mat& dst) override;
+  std::unique_ptr<ImageStage> Clone() const override {return CloneAs<GlareSuppressionStage>();}
+private:
+  static constexpr int s_downscale = 4; // the glare is detected and inpainted on a smaller image
+  cv::Mat m_small, m_hsv, m_mask, m_kernel, m_inpainted, m_inpaintedFull, m_maskFull;
+  int m_kernelSize = -1;
+};
+
+struct ClaheParams
+{
+  float clipLimit = 2.0f;
+  int tileGridSize = 8;
+};
+
+class ClaheStage : public ParameterizedStage<ClaheParams>
+{
+public:
+  ClaheStage() : ParameterizedStage("CLAHE contrast"){}
+  void Process(const cv::Mat& src, cv::Mat& dst) override;
+  std::unique_ptr<ImageStage> Clone() const override {return CloneAs<ClaheStage>();}
+private:
+  cv::Ptr<cv::CLAHE> m_clahe;
+  cv::Mat m_lab;
+  std::vector<cv::Mat> m_labChannels;
+};
+
+struct SharpenParams
+{
+  float amount = 0.6f;
+  float sigma = 1.5f;
+};
+
+class SharpenStage : public ParameterizedStage<SharpenParams>
+{
+public:
+  SharpenStage() : ParameterizedStage("Sharpen"){}
+  void Process(const cv::Mat& src, cv::Mat& dst) override;
+  std::unique_ptr<ImageStage> Clone() const override {return CloneAs<SharpenStage>();}
+private:
+  cv::Mat m_blurred;
+};
+
+/// @brief Chain of the enhancement stages: white balance -> glare suppression -> CLAHE -> sharpen.
+///         An instance is used by one thread, for another thread (e.g. the stills) a clone has to be made
+class ImagePipeline
+{
+public:
+  ImagePipeline();
+  // returns src itself when all the stages are bypassed, otherwise one of the reused output buffers
+  const cv::Mat& Process(const cv::Mat& src);
+  std::unique_ptr<ImagePipeline> Clone() const;
+  bool HasEnabledStage() const;
+
+  const std::vector<std::unique_ptr<ImageStage>>& GetStages() const {return m_stages;}
+  template<typename StageType>
+  StageType* GetStage()
+  {
+    for(auto& stage : m_stages)
+    {
+      if(auto* typedStage = dynamic_cast<StageType*>(stage.get()))
+        return typedStage;
+    }
+    return nullptr;
+  }
+private:
+  ImagePipeline(std::vector<std::unique_ptr<ImageStage>> stages) : m_stages(std::move(stages)){}
+  std::vector<std::unique_ptr<ImageStage>> m_stages;
+  cv::Mat m_buffers[2]; // ping-pong buffers between the stages
+};
+
+} // namespace medicimage
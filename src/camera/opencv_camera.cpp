@@ -1,4 +1,5 @@
 #include "camera/opencv_camera.h"
+#include "camera/device_monitor.h"
 #include "core/log.h"
 #include "opencv2/core/directx.hpp"
 #include "opencv2/core/ocl.hpp"
@@ -10,8 +11,14 @@
 namespace medicimage
 {
 
-void OpenCvCamera::Init()
+OpenCvCamera::OpenCvCamera(const std::vector<std::string>& deviceNames) : m_deviceNames(deviceNames)
 {
+  m_numberOfDevices = static_cast<int>(m_deviceNames.size());
+}
+
+std::vector<std::string> OpenCvCamera::EnumerateDevices()
+{
+  std::vector<std::string> deviceNames;
   std::vector<cv::VideoCapture> devices;
   cv::VideoCapture temp;
 
@@ -22,23 +29,35 @@ void OpenCvCamera::Init()
     if (!temp.isOpened())
       break;
     std::string deviceName = std::string("Camera") + std::to_string(i);
-    m_deviceNames.push_back(deviceName);
+    deviceNames.push_back(deviceName);
     devices.push_back(temp);
   }
 
-  m_numberOfDevices = devices.size();
-  APP_CORE_INFO("Number of cameras attached: {0}", m_numberOfDevices);
+  APP_CORE_INFO("Number of cameras attached: {0}", deviceNames.size());
   for(auto& device : devices)
   {
     device.release();
   }
+  return deviceNames;
+}
+
+void OpenCvCamera::Init()
+{
+  m_deviceNames = EnumerateDevices();
+  m_numberOfDevices = static_cast<int>(m_deviceNames.size());
+}
+
+OpenCvCamera::~OpenCvCamera()
+{
+  Close();
 }
 
 void OpenCvCamera::Open(int index)
 {
   assert(index < m_numberOfDevices && "Camera ID is out of range!");
-  m_cap.open(index, cv::CAP_DSHOW);
-  if(!m_cap.isOpened())
+  std::scoped_lock lock(m_deviceMutex);
+  CloseDevice();
+  if(!OpenDevice(index))
   {
     m_selectedDevice = -1;
     m_opened = false;
@@ -48,34 +67,138 @@ void OpenCvCamera::Open(int index)
   {
     m_opened = true;
     m_selectedDevice = index;
+    const auto devices = DeviceMonitor::ListCaptureDevices();
+    m_deviceId = index < static_cast<int>(devices.size()) ? DeviceMonitor::GetDeviceId(devices[index]) : std::string();
   }
 }
 
-CameraAPI::Frame OpenCvCamera::CaptureFrame()
+bool OpenCvCamera::Reconnect()
+{
+  std::scoped_lock lock(m_deviceMutex);
+  if(!m_connectionLost || m_deviceId.empty())
+    return false;
+  const auto devices = DeviceMonitor::ListCaptureDevices();
+  auto device = std::find_if(devices.begin(), devices.end(), [this](const std::string& path) { return DeviceMonitor::GetDeviceId(path) == m_deviceId; });
+  if(device == devices.end())
+    return false;
+  const int index = static_cast<int>(std::distance(devices.begin(), device));
+  CloseDevice();
+  if(!OpenDevice(index))
+    return false;
+  m_selectedDevice = index;
+  APP_CORE_INFO("Camera:{} reconnected with index:{}", m_deviceId, index);
+  return true;
+}
+
+std::string OpenCvCamera::GetDeviceId()
+{
+  std::scoped_lock lock(m_deviceMutex);
+  return m_deviceId;
+}
+
+bool OpenCvCamera::OpenDevice(int index)
 {
+  m_cap.open(index, cv::CAP_DSHOW);
   if(!m_cap.isOpened())
+    return false;
+  double fps = m_cap.get(cv::CAP_PROP_FPS);
+  if(fps > 0.0)
+    m_frameRate = fps;
+  m_connectionLost = false;
+  m_capturing = true;
+  m_captureThread = std::thread(&OpenCvCamera::CaptureLoop, this);
+  return true;
+}
+
+void OpenCvCamera::CloseDevice()
+{
+  m_capturing = false;
+  if(m_captureThread.joinable())
+    m_captureThread.join();
+  m_cap.release();
+  std::scoped_lock lock(m_previewMutex);
+  m_newPreview = false;
+}
+
+void OpenCvCamera::CaptureLoop()
+{
+  cv::Mat resizedFrame, distortedFrame;
+  while(m_capturing)
   {
-    APP_CORE_ERR("OpenCV camera capture closed unexpectedly!");
-    return CameraAPI::Frame();
+    // grab() returns when the frame is acquired, the decoding in retrieve() is already part of the conversion
+    if(!m_cap.grab())
+    {
+      // most probably the device was unplugged, the device monitor reconnects it when it shows up again
+      APP_CORE_ERR("OpenCV camera capture closed unexpectedly!");
+      m_connectionLost = true;
+      break;
+    }
+    FrameTimestamps timestamps = NextFrameTimestamps();
+    // still stream: the raw frame is kept in sensor resolution and it is not uploaded
+    cv::Mat& rawFrame = m_stillFrames.BeginWrite();
+    // with lens correction the frame is retrieved into a separate buffer and remapped into the ring slot
+    const bool undistort = m_undistortion.IsActive();
+    if(!m_cap.retrieve(undistort ? distortedFrame : rawFrame))
+      continue;
+    if(undistort)
+      m_undistortion.Apply(distortedFrame, rawFrame);
+    NotifyRawFrame(rawFrame);
+
+    // preview stream: downscaled once to the size of the canvas, so only that much has to be converted and uploaded
+    const cv::Size previewSize = GetPreviewSize(rawFrame.size());
+    const cv::Mat* previewFrame = &rawFrame;
+    if(previewSize != rawFrame.size())
+    {
+      cv::resize(rawFrame, resizedFrame, previewSize);
+      previewFrame = &resizedFrame;
+    }
+    // the enhancement runs on the preview resolution, the stills get it only when they are saved
+    const cv::Mat& enhancedFrame = m_imagePipeline.Process(*previewFrame);
+    cv::cvtColor(enhancedFrame, m_previewWrite, cv::COLOR_BGR2RGBA);
+    m_stillFrames.EndWrite();
+    timestamps.converted = FrameClock::now();
+
+    std::scoped_lock lock(m_previewMutex);
+    std::swap(m_previewWrite, m_previewReady);
+    m_previewReadyTimestamps = timestamps;
+    m_newPreview = true;
   }
+}
 
-  constexpr int width = 1920;
-  constexpr int height = 1080; 
-  cv::UMat frame;
-  m_cap.read(frame);
-  cv::resize(frame, frame, cv::Size(width, height));
-  cv::cvtColor(frame, frame, cv::COLOR_BGR2RGBA);
-  
-  Frame frameTexture = std::make_unique<Texture2D>("frame", frame.cols, frame.rows);
-  cv::directx::convertToD3D11Texture2D(frame, frameTexture.value()->GetTexturePtr());
-  frame.release();
-  return std::move(frameTexture);
+bool OpenCvCamera::UpdatePreview(std::unique_ptr<Texture2D>& preview)
+{
+  FrameTimestamps timestamps;
+  {
+    std::scoped_lock lock(m_previewMutex);
+    if(!m_newPreview)
+      return false;
+    std::swap(m_previewReady, m_previewRead);
+    timestamps = m_previewReadyTimestamps;
+    m_newPreview = false;
+  }
+
+  // the D3D11 immediate context is used only from the UI thread, the upload happens here
+  const unsigned int width = m_previewRead.cols;
+  const unsigned int height = m_previewRead.rows;
+  const unsigned int rowPitch = static_cast<unsigned int>(m_previewRead.step);
+  if(preview == nullptr || preview->GetWidth() != width || preview->GetHeight() != height)
+    preview = std::make_unique<Texture2D>("frame", width, height, m_previewRead.data, rowPitch);
+  else
+    preview->Update(m_previewRead.data, rowPitch);
+  timestamps.uploaded = FrameClock::now();
+  preview->SetFrameTimestamps(timestamps);
+  return true;
 }
 
 void OpenCvCamera::Close()
 {
-  m_cap.release();
+  std::scoped_lock lock(m_deviceMutex);
+  CloseDevice();
+  m_stillFrames.Clear();
+  m_opened = false;
+  m_connectionLost = false;
 }
+
 std::string OpenCvCamera::GetDeviceName(int index)
 {
   return m_deviceNames[index];
@@ -6,21 +6,52 @@
 #include <opencv2/videoio.hpp>
 #include <opencv2/highgui.hpp>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 namespace medicimage
 {
 
 class OpenCvCamera final : public CameraAPI
 {
 public:
-  ~OpenCvCamera() = default;
+  OpenCvCamera() = default;
+  // for opening one of the already enumerated devices, without probing all of them again
+  OpenCvCamera(const std::vector<std::string>& deviceNames);
+  ~OpenCvCamera();
+  static std::vector<std::string> EnumerateDevices();
   void Init() override;  
   void Open(int index) override;
-  CameraAPI::Frame CaptureFrame() override;
+  bool UpdatePreview(std::unique_ptr<Texture2D>& preview) override;
   void Close() override;
   std::string GetDeviceName(int index) override;
+  // the capture stopped because the device disappeared, the camera still counts as opened until Close()
+  bool IsConnectionLost() const {return m_connectionLost;}
+  // reopens the previously selected device after its connection was lost, it is looked up by its device id,
+  // because the capture indices can shift when the devices are unplugged and plugged again
+  bool Reconnect();
+  // the device instance of the opened device (see DeviceMonitor::GetDeviceId), empty when it is not known
+  std::string GetDeviceId();
 private:
-  cv::VideoCapture m_cap;
+  bool OpenDevice(int index);
+  void CloseDevice();
+  void CaptureLoop();
+
+  cv::VideoCapture m_cap; // only used by the capture thread while it is running
   std::vector<std::string> m_deviceNames;
+  std::string m_deviceId;
+  std::thread m_captureThread;
+  std::atomic<bool> m_capturing = false;
+  std::atomic<bool> m_connectionLost = false;
+  std::mutex m_deviceMutex; // open, close and reconnect can come from the UI and the device monitor thread
+
+  // preview triple buffer: the capture thread fills the write buffer and swaps it with the ready one,
+  // the UI thread swaps the ready one to the read buffer and uploads it, so none of them waits for the other
+  std::mutex m_previewMutex;
+  cv::Mat m_previewWrite, m_previewReady, m_previewRead;
+  FrameTimestamps m_previewReadyTimestamps;
+  bool m_newPreview = false;
 };
  
 } // namespace medicimage
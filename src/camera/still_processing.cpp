@@ -0,0 +1,103 @@
+#include "camera/still_processing.h"
+#include "core/log.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+namespace medicimage
+{
+
+cv::Mat StillProcessing::DownsampledGray(const cv::Mat& image, double scale, int type)
+{
+  cv::Mat small;
+  cv::resize(image, small, cv::Size(), scale, scale, cv::INTER_AREA);
+  cv::Mat gray;
+  if(small.channels() == 1)
+    gray = small;
+  else
+    cv::cvtColor(small, gray, small.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+  if(gray.depth() != type)
+    gray.convertTo(gray, type);
+  return gray;
+}
+
+double StillProcessing::FocusMeasure(const cv::Mat& image)
+{
+  if(image.empty())
+    return 0.0;
+
+  // the blur is visible on the downsampled image as well, and the metric gets an order of magnitude cheaper
+  const double scale = std::min(1.0, static_cast<double>(s_focusMeasureWidth) / image.cols);
+  cv::Mat gray = DownsampledGray(image, scale, CV_8U);
+
+  // 16 bit signed output keeps the vectorized path of the Laplacian and does not saturate
+  cv::Mat laplacian;
+  cv::Laplacian(gray, laplacian, CV_16S);
+  cv::Scalar mean, stddev;
+  cv::meanStdDev(laplacian, mean, stddev);
+  return stddev[0] * stddev[0];
+}
+
+size_t StillProcessing::SelectSharpest(const std::vector<cv::Mat>& frames)
+{
+  size_t sharpest = 0;
+  double bestFocus = -1.0;
+  for(size_t i = 0; i < frames.size(); i++)
+  {
+    const double focus = FocusMeasure(frames[i]);
+    if(focus > bestFocus)
+    {
+      bestFocus = focus;
+      sharpest = i;
+    }
+  }
+  APP_CORE_TRACE("Sharpest frame of the burst: {}/{} focus:{:.1f}", sharpest + 1, frames.size(), bestFocus);
+  return sharpest;
+}
+
+cv::Mat StillProcessing::AverageAligned(const std::vector<cv::Mat>& frames)
+{
+  if(frames.empty())
+    return cv::Mat();
+  const cv::Mat& reference = frames.back();
+  if(frames.size() == 1)
+    return reference.clone();
+
+  // the shift is estimated on a small grayscale copy, the hanning window suppresses the edge effects of the FFT
+  const double scale = std::min(1.0, static_cast<double>(s_alignmentWidth) / reference.cols);
+  cv::Mat referenceGray = DownsampledGray(reference, scale, CV_32F);
+  cv::Mat window;
+  cv::createHanningWindow(window, referenceGray.size(), CV_32F);
+
+  // streaming accumulation: every frame is warped and added once, only one float buffer is kept
+  cv::Mat accumulator(reference.size(), CV_MAKETYPE(CV_32F, reference.channels()), cv::Scalar::all(0));
+  cv::accumulate(reference, accumulator);
+  int accumulatedFrames = 1;
+  cv::Mat aligned;
+  for(size_t i = 0; i + 1 < frames.size(); i++)
+  {
+    const cv::Mat& frame = frames[i];
+    if(frame.size() != reference.size() || frame.type() != reference.type())
+      continue;
+
+    double response = 0.0;
+    cv::Point2d shift = cv::phaseCorrelate(referenceGray, DownsampledGray(frame, scale, CV_32F), window, &response);
+    if(response < s_minAlignmentResponse)
+    {
+      APP_CORE_TRACE("Frame {} of the stack skipped, alignment response:{:.3f}", i, response);
+      continue;
+    }
+    cv::Matx23d translation(1.0, 0.0, -shift.x / scale, 0.0, 1.0, -shift.y / scale);
+    cv::warpAffine(frame, aligned, translation, reference.size(), cv::INTER_LINEAR, cv::BORDER_REFLECT);
+    cv::accumulate(aligned, accumulator);
+    accumulatedFrames++;
+  }
+
+  cv::Mat result;
+  accumulator.convertTo(result, reference.type(), 1.0 / accumulatedFrames);
+  APP_CORE_TRACE("Temporal denoise averaged {}/{} frames", accumulatedFrames, frames.size());
+  return result;
+}
+
+} // namespace medicimage
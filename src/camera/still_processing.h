@@ -0,0 +1,28 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief Processing steps done on the full resolution stills before saving them
+class StillProcessing
+{
+public:
+  // variance of the Laplacian on a downsampled grayscale copy, higher is sharper
+  static double FocusMeasure(const cv::Mat& image);
+  // index of the sharpest frame of the burst
+  static size_t SelectSharpest(const std::vector<cv::Mat>& frames);
+  // temporal denoise: aligns the frames to the newest one with a translation and averages them
+  static cv::Mat AverageAligned(const std::vector<cv::Mat>& frames);
+private:
+  static cv::Mat DownsampledGray(const cv::Mat& image, double scale, int type);
+
+  static constexpr int s_focusMeasureWidth = 480;
+  static constexpr int s_alignmentWidth = 480;
+  static constexpr double s_minAlignmentResponse = 0.05; // frames correlating worse than this would only add ghosting
+};
+
+} // namespace medicimage
@@ -0,0 +1,116 @@
+#include "camera/undistortion.h"
+#include "core/log.h"
+#include "json.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <fstream>
+#include <optional>
+
+namespace medicimage
+{
+
+using json = nlohmann::json;
+
+bool Undistortion::LoadCalibration(const std::filesystem::path& calibrationFile)
+{
+  std::ifstream file(calibrationFile);
+  if(!file.good())
+    return false;
+
+  try
+  {
+    json calibration;
+    file >> calibration;
+    auto cameraMatrix = calibration.at("cameraMatrix").get<std::vector<double>>();
+    auto distCoeffs = calibration.at("distCoeffs").get<std::vector<double>>();
+    const cv::Size imageSize(calibration.at("imageWidth").get<int>(), calibration.at("imageHeight").get<int>());
+    // the image size divides the camera matrix when it is scaled to the frame size
+    if(cameraMatrix.size() != 9 || distCoeffs.empty() || imageSize.width <= 0 || imageSize.height <= 0)
+    {
+      APP_CORE_ERR("Invalid camera calibration in:{}", calibrationFile.string());
+      return false;
+    }
+
+    // new matrices are assigned, the ones the capture thread took a reference to are left unchanged
+    std::scoped_lock lock(m_mutex);
+    m_calibration.cameraMatrix = cv::Mat(3, 3, CV_64F, cameraMatrix.data()).clone();
+    m_calibration.distCoeffs = cv::Mat(1, static_cast<int>(distCoeffs.size()), CV_64F, distCoeffs.data()).clone();
+    m_calibration.imageSize = imageSize;
+    m_calibrationVersion++;
+    m_hasCalibration = true;
+  }
+  catch(const std::exception& e)
+  {
+    APP_CORE_ERR("Could not load camera calibration from:{}, exception:{}", calibrationFile.string(), e.what());
+    return false;
+  }
+  APP_CORE_INFO("Camera calibration loaded from:{}", calibrationFile.string());
+  return true;
+}
+
+void Undistortion::BuildMaps(const Calibration& calibration, cv::Size frameSize)
+{
+  // the calibration can be made in another resolution than the one the camera runs with
+  cv::Mat cameraMatrix = calibration.cameraMatrix.clone();
+  const double scaleX = static_cast<double>(frameSize.width) / calibration.imageSize.width;
+  const double scaleY = static_cast<double>(frameSize.height) / calibration.imageSize.height;
+  cameraMatrix.at<double>(0, 0) *= scaleX;
+  cameraMatrix.at<double>(0, 2) *= scaleX;
+  cameraMatrix.at<double>(1, 1) *= scaleY;
+  cameraMatrix.at<double>(1, 2) *= scaleY;
+
+  // alpha = 0: only valid pixels are kept, so there are no black borders on the corrected image
+  cv::Mat newCameraMatrix = cv::getOptimalNewCameraMatrix(cameraMatrix, calibration.distCoeffs, frameSize, 0.0);
+  cv::initUndistortRectifyMap(cameraMatrix, calibration.distCoeffs, cv::Mat(), newCameraMatrix, frameSize, CV_16SC2, m_map1, m_map2);
+  m_mapSize = frameSize;
+  APP_CORE_INFO("Undistortion tables built for {}x{}", frameSize.width, frameSize.height);
+}
+
+void Undistortion::Apply(const cv::Mat& src, cv::Mat& dst)
+{
+  // the calibration is copied under the lock only when the maps have to be rebuilt, the matrices are shared, not cloned
+  bool calibrated = false;
+  std::optional<Calibration> calibration;
+  uint64_t calibrationVersion = 0;
+  {
+    std::scoped_lock lock(m_mutex);
+    calibrated = !m_calibration.cameraMatrix.empty();
+    if(calibrated && (m_mapSize != src.size() || m_mapVersion != m_calibrationVersion))
+    {
+      calibration = m_calibration;
+      calibrationVersion = m_calibrationVersion;
+    }
+  }
+  if(!calibrated || src.empty())
+  {
+    src.copyTo(dst);
+    return;
+  }
+  if(calibration.has_value())
+  {
+    BuildMaps(calibration.value(), src.size());
+    m_mapVersion = calibrationVersion;
+  }
+  const auto start = FrameClock::now();
+  cv::remap(src, dst, m_map1, m_map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+  const auto elapsed = FrameClock::now() - start;
+
+  std::scoped_lock lock(m_mutex);
+  m_timing.Record(elapsed);
+}
+
+LatencyHistogram Undistortion::GetTiming() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_timing;
+}
+
+void Undistortion::ResetTiming()
+{
+  std::scoped_lock lock(m_mutex);
+  m_timing.Reset();
+}
+
+} // namespace medicimage
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/frame_timing.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+
+namespace medicimage
+{
+
+/// @brief Lens distortion correction of the camera frames. The remap tables are computed once from the
+///         per device calibration in fixed point format, so a frame costs a single vectorized remap
+class Undistortion
+{
+public:
+  Undistortion() = default;
+  // calibration json: {"imageWidth", "imageHeight", "cameraMatrix": [9 values row-major], "distCoeffs": [4, 5, 8.. values]}
+  bool LoadCalibration(const std::filesystem::path& calibrationFile);
+  bool HasCalibration() const {return m_hasCalibration;}
+  void SetEnabled(bool enabled){m_enabled = enabled;}
+  bool IsEnabled() const {return m_enabled;}
+  bool IsActive() const {return m_enabled && HasCalibration();}
+  // the tables are rebuilt only when the frame size changes
+  void Apply(const cv::Mat& src, cv::Mat& dst);
+  LatencyHistogram GetTiming() const;
+  void ResetTiming();
+
+  static constexpr double s_budgetMs = 2.0;
+private:
+  struct Calibration
+  {
+    cv::Mat cameraMatrix;
+    cv::Mat distCoeffs;
+    cv::Size imageSize;
+  };
+  void BuildMaps(const Calibration& calibration, cv::Size frameSize);
+
+  // the mutex guards only the calibration and the timing, the remap runs without it, so GetTiming does not wait for it
+  mutable std::mutex m_mutex;
+  Calibration m_calibration;
+  uint64_t m_calibrationVersion = 0; // the maps are rebuilt when it changes
+  LatencyHistogram m_timing;
+  // used only by the thread calling Apply
+  cv::Mat m_map1, m_map2; // CV_16SC2 integer coordinates and CV_16UC1 interpolation table indices
+  cv::Size m_mapSize;
+  uint64_t m_mapVersion = 0;
+  std::atomic<bool> m_enabled = false;
+  std::atomic<bool> m_hasCalibration = false;
+};
+
+} // namespace medicimage
@@ -0,0 +1,176 @@
+#include "camera/video_recorder.h"
+#include "core/log.h"
+#include "core/frame_timing.h"
+
+#include <assert.h>
+
+namespace medicimage
+{
+
+VideoRecorder::VideoRecorder(size_t queueCapacity, DropPolicy dropPolicy)
+  : m_dropPolicy(dropPolicy), m_slots(queueCapacity)
+{
+  assert(queueCapacity > 1 && "The recorder queue needs at least two slots");
+}
+
+VideoRecorder::~VideoRecorder()
+{
+  Stop();
+}
+
+bool VideoRecorder::Start(const std::filesystem::path& filePath, double fps)
+{
+  if(m_recording)
+  {
+    APP_CORE_WARN("Recording is already running into:{}", m_filePath.string());
+    return false;
+  }
+
+  m_filePath = filePath;
+  m_fps = fps > 0.0 ? fps : 30.0;
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stopRequested = false;
+    m_queuedSlots.clear();
+    m_freeSlots.clear();
+    for(size_t i = 0; i < m_slots.size(); i++)
+      m_freeSlots.push_back(i);
+    m_encodedFrames = 0;
+    m_droppedFrames = 0;
+    m_encodeFps = 0.0;
+  }
+  m_recording = true;
+  m_encoderThread = std::thread(&VideoRecorder::EncodeLoop, this);
+  APP_CORE_INFO("Recording started into:{}", m_filePath.string());
+  return true;
+}
+
+void VideoRecorder::Stop()
+{
+  if(!m_encoderThread.joinable())
+    return;
+
+  m_recording = false;
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stopRequested = true;
+  }
+  m_frameQueued.notify_one();
+  m_encoderThread.join();
+  APP_CORE_INFO("Recording stopped, {} frames encoded, {} dropped", m_encodedFrames, m_droppedFrames);
+}
+
+void VideoRecorder::PushFrame(const cv::Mat& frame)
+{
+  if(!m_recording || frame.empty())
+    return;
+
+  size_t slot;
+  {
+    std::scoped_lock lock(m_mutex);
+    if(!m_freeSlots.empty())
+    {
+      slot = m_freeSlots.back();
+      m_freeSlots.pop_back();
+    }
+    else if(m_dropPolicy == DropPolicy::DROP_OLDEST && !m_queuedSlots.empty())
+    {
+      // the oldest frame waiting for the encoder is overwritten by the new one
+      slot = m_queuedSlots.front();
+      m_queuedSlots.pop_front();
+      m_droppedFrames++;
+    }
+    else
+    {
+      m_droppedFrames++;
+      return;
+    }
+  }
+
+  // the slot is owned by this thread until it is queued, the copy reuses its buffer
+  frame.copyTo(m_slots[slot]);
+  {
+    std::scoped_lock lock(m_mutex);
+    m_queuedSlots.push_back(slot);
+  }
+  m_frameQueued.notify_one();
+}
+
+void VideoRecorder::EncodeLoop()
+{
+  auto fpsWindowStart = FrameClock::now();
+  uint64_t fpsWindowFrames = 0;
+  while(true)
+  {
+    size_t slot;
+    {
+      std::unique_lock lock(m_mutex);
+      m_frameQueued.wait(lock, [this]{return m_stopRequested || !m_queuedSlots.empty();});
+      if(m_queuedSlots.empty())
+        break;  // stop requested and the queue is drained
+      slot = m_queuedSlots.front();
+      m_queuedSlots.pop_front();
+    }
+
+    const cv::Mat& frame = m_slots[slot];
+    if(!m_writer.isOpened())
+    {
+      // the frame size is known only from the first frame
+      m_writer.open(m_filePath.string(), cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), m_fps, frame.size());
+      if(!m_writer.isOpened())
+        APP_CORE_ERR("Could not open video file:{} for recording", m_filePath.string());
+    }
+    if(m_writer.isOpened())
+      m_writer.write(frame);
+
+    fpsWindowFrames++;
+    const auto now = FrameClock::now();
+    const double windowSeconds = std::chrono::duration<double>(now - fpsWindowStart).count();
+    std::scoped_lock lock(m_mutex);
+    m_freeSlots.push_back(slot);
+    m_encodedFrames++;
+    if(windowSeconds >= 1.0)
+    {
+      m_encodeFps = fpsWindowFrames / windowSeconds;
+      fpsWindowStart = now;
+      fpsWindowFrames = 0;
+    }
+  }
+  m_writer.release();
+}
+
+void VideoRecorder::SetDropPolicy(DropPolicy dropPolicy)
+{
+  std::scoped_lock lock(m_mutex);
+  m_dropPolicy = dropPolicy;
+}
+
+VideoRecorder::DropPolicy VideoRecorder::GetDropPolicy() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_dropPolicy;
+}
+
+VideoRecorder::Stats VideoRecorder::GetStats() const
+{
+  std::scoped_lock lock(m_mutex);
+  Stats stats;
+  stats.encodeFps = m_encodeFps;
+  stats.queueDepth = m_queuedSlots.size();
+  stats.queueCapacity = m_slots.size();
+  stats.encodedFrames = m_encodedFrames;
+  stats.droppedFrames = m_droppedFrames;
+  return stats;
+}
+
+const char* VideoRecorder::GetDropPolicyName(DropPolicy dropPolicy)
+{
+  switch(dropPolicy)
+  {
+    case DropPolicy::DROP_NEWEST: return "drop newest";
+    case DropPolicy::DROP_OLDEST: return "drop oldest";
+    default: return "unknown";
+  }
+}
+
+} // namespace medicimage
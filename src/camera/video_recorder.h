@@ -0,0 +1,68 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief Records the camera frames into an MJPEG/AVI file. The frames are copied into a bounded pool of
+///         preallocated slots and encoded on a background thread, so a slow encoder never blocks the capture
+class VideoRecorder
+{
+public:
+  // what happens with a new frame when all the slots are waiting for the encoder
+  enum class DropPolicy{DROP_NEWEST, DROP_OLDEST};
+  struct Stats
+  {
+    double encodeFps = 0.0;
+    size_t queueDepth = 0;
+    size_t queueCapacity = 0;
+    uint64_t encodedFrames = 0;
+    uint64_t droppedFrames = 0;
+  };
+public:
+  VideoRecorder(size_t queueCapacity = s_defaultQueueCapacity, DropPolicy dropPolicy = DropPolicy::DROP_OLDEST);
+  ~VideoRecorder();
+  bool Start(const std::filesystem::path& filePath, double fps);
+  void Stop(); // encodes the frames still in the queue before closing the file
+  bool IsRecording() const {return m_recording;}
+  // called from the capture thread, it never waits for the encoder
+  void PushFrame(const cv::Mat& frame);
+  void SetDropPolicy(DropPolicy dropPolicy);
+  DropPolicy GetDropPolicy() const;
+  Stats GetStats() const;
+  const std::filesystem::path& GetFilePath() const {return m_filePath;}
+
+  static const char* GetDropPolicyName(DropPolicy dropPolicy);
+  static constexpr size_t s_defaultQueueCapacity = 8;
+private:
+  void EncodeLoop();
+
+  std::filesystem::path m_filePath;
+  double m_fps = 30.0;
+  cv::VideoWriter m_writer; // only used by the encoder thread
+  std::thread m_encoderThread;
+  std::atomic<bool> m_recording = false;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_frameQueued;
+  bool m_stopRequested = false;
+  DropPolicy m_dropPolicy;
+  std::vector<cv::Mat> m_slots;
+  std::vector<size_t> m_freeSlots;
+  std::deque<size_t> m_queuedSlots;
+  uint64_t m_encodedFrames = 0;
+  uint64_t m_droppedFrames = 0;
+  double m_encodeFps = 0.0;
+};
+
+} // namespace medicimage
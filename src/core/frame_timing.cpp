@@ -0,0 +1,158 @@
+#include "core/frame_timing.h"
+#include "core/log.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+
+namespace medicimage
+{
+
+using json = nlohmann::json;
+
+size_t LatencyHistogram::BucketIndex(uint64_t valueUs)
+{
+  constexpr uint64_t halfCount = s_subBucketCount / 2;
+  if(valueUs < s_subBucketCount)
+    return static_cast<size_t>(valueUs);
+
+  // the top s_subBucketBits bits of the value select the linear sub-bucket inside the power of two range
+  const int msb = std::bit_width(valueUs) - 1;
+  const int shift = msb - (s_subBucketBits - 1);
+  const uint64_t top = valueUs >> shift;
+  return static_cast<size_t>(s_subBucketCount + (shift - 1) * halfCount + (top - halfCount));
+}
+
+uint64_t LatencyHistogram::BucketHighestValue(size_t index)
+{
+  constexpr uint64_t halfCount = s_subBucketCount / 2;
+  if(index < s_subBucketCount)
+    return index;
+
+  const uint64_t k = index - s_subBucketCount;
+  const uint64_t shift = k / halfCount + 1;
+  const uint64_t top = k % halfCount + halfCount;
+  return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(FrameClock::duration latency)
+{
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  uint64_t valueUs = std::clamp<int64_t>(us, 0, static_cast<int64_t>(s_maxTrackableUs));
+  m_buckets[BucketIndex(valueUs)]++;
+  m_count++;
+  m_sumUs += valueUs;
+  m_maxUs = std::max(m_maxUs, valueUs);
+}
+
+void LatencyHistogram::Reset()
+{
+  m_buckets.fill(0);
+  m_count = 0;
+  m_sumUs = 0;
+  m_maxUs = 0;
+}
+
+double LatencyHistogram::GetPercentileMs(double percentile) const
+{
+  if(m_count == 0)
+    return 0.0;
+
+  const double clamped = std::clamp(percentile, 0.0, 100.0);
+  const uint64_t targetCount = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * m_count)));
+  uint64_t accumulated = 0;
+  for(size_t i = 0; i < m_buckets.size(); i++)
+  {
+    accumulated += m_buckets[i];
+    if(accumulated >= targetCount)
+      return static_cast<double>(std::min(BucketHighestValue(i), m_maxUs)) / 1000.0;
+  }
+  return GetMaxMs();
+}
+
+double LatencyHistogram::GetMeanMs() const
+{
+  if(m_count == 0)
+    return 0.0;
+  return static_cast<double>(m_sumUs) / static_cast<double>(m_count) / 1000.0;
+}
+
+void CameraLatencyStats::OnFramePresented(const FrameTimestamps& timestamps, FrameClock::time_point presented)
+{
+  // frames not coming from the camera and frames shown on multiple UI frames are not counted
+  if(timestamps.sequence == 0 || timestamps.sequence <= m_lastPresentedSequence)
+    return;
+
+  if(m_lastPresentedSequence != 0 && timestamps.sequence > m_lastPresentedSequence + 1)
+    m_droppedFrames += timestamps.sequence - m_lastPresentedSequence - 1;
+  m_lastPresentedSequence = timestamps.sequence;
+  m_presentedFrames++;
+
+  m_histograms[static_cast<size_t>(Stage::CAPTURE_TO_CONVERT)].Record(timestamps.converted - timestamps.captured);
+  m_histograms[static_cast<size_t>(Stage::CONVERT_TO_UPLOAD)].Record(timestamps.uploaded - timestamps.converted);
+  m_histograms[static_cast<size_t>(Stage::UPLOAD_TO_PRESENT)].Record(presented - timestamps.uploaded);
+  auto endToEnd = presented - timestamps.captured;
+  m_histograms[static_cast<size_t>(Stage::CAPTURE_TO_PRESENT)].Record(endToEnd);
+  if(endToEnd > m_frameBudget)
+    m_lateFrames++;
+}
+
+void CameraLatencyStats::Reset()
+{
+  for(auto& histogram : m_histograms)
+    histogram.Reset();
+  m_lastPresentedSequence = 0;
+  m_presentedFrames = 0;
+  m_droppedFrames = 0;
+  m_lateFrames = 0;
+}
+
+const char* CameraLatencyStats::GetStageName(Stage stage)
+{
+  switch(stage)
+  {
+    case Stage::CAPTURE_TO_CONVERT: return "capture->convert";
+    case Stage::CONVERT_TO_UPLOAD:  return "convert->upload";
+    case Stage::UPLOAD_TO_PRESENT:  return "upload->present";
+    case Stage::CAPTURE_TO_PRESENT: return "capture->present";
+    default: return "unknown";
+  }
+}
+
+bool CameraLatencyStats::ExportJson(const std::filesystem::path& path) const
+{
+  json stages = json::object();
+  for(size_t i = 0; i < m_histograms.size(); i++)
+  {
+    const auto& histogram = m_histograms[i];
+    stages[GetStageName(static_cast<Stage>(i))] = {
+      {"count", histogram.GetCount()},
+      {"meanMs", histogram.GetMeanMs()},
+      {"p50Ms", histogram.GetPercentileMs(50.0)},
+      {"p90Ms", histogram.GetPercentileMs(90.0)},
+      {"p99Ms", histogram.GetPercentileMs(99.0)},
+      {"maxMs", histogram.GetMaxMs()}
+    };
+  }
+  json stats = {
+    {"presentedFrames", m_presentedFrames},
+    {"droppedFrames", m_droppedFrames},
+    {"lateFrames", m_lateFrames},
+    {"frameBudgetMs", std::chrono::duration<double, std::milli>(m_frameBudget).count()},
+    {"stages", stages}
+  };
+
+  std::ofstream file(path);
+  if(!file.good())
+  {
+    APP_CORE_ERR("Could not export camera latency stats into:{}", path.string());
+    return false;
+  }
+  file << stats.dump(2);
+  APP_CORE_INFO("Camera latency stats exported into:{}", path.string());
+  return true;
+}
+
+} // namespace medicimage
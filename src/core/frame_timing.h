@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace medicimage
+{
+
+using FrameClock = std::chrono::steady_clock;
+
+// timestamps of a camera frame along the capture -> convert -> upload -> present pipeline
+struct FrameTimestamps
+{
+  uint64_t sequence = 0;  // 0 means the frame did not come from a camera
+  FrameClock::time_point captured;
+  FrameClock::time_point converted;
+  FrameClock::time_point uploaded;
+};
+
+/// @brief HDR histogram style latency recorder: every power of two range is split into linear sub-buckets,
+///         so the relative error is bounded over the whole range without storing the samples
+class LatencyHistogram
+{
+public:
+  LatencyHistogram() = default;
+  void Record(FrameClock::duration latency);
+  void Reset();
+  uint64_t GetCount() const {return m_count;}
+  double GetPercentileMs(double percentile) const;
+  double GetMeanMs() const;
+  double GetMaxMs() const {return static_cast<double>(m_maxUs) / 1000.0;}
+private:
+  static size_t BucketIndex(uint64_t valueUs);
+  static uint64_t BucketHighestValue(size_t index);
+
+  static constexpr int s_subBucketBits = 4; // 16 linear sub-buckets -> ~6% precision
+  static constexpr uint64_t s_subBucketCount = 1 << s_subBucketBits;
+  static constexpr uint64_t s_maxTrackableUs = (uint64_t(1) << 24) - 1; // ~16 seconds
+  static constexpr size_t s_bucketCount = s_subBucketCount + (24 - s_subBucketBits) * (s_subBucketCount / 2);
+  std::array<uint64_t, s_bucketCount> m_buckets{};
+  uint64_t m_count = 0;
+  uint64_t m_sumUs = 0;
+  uint64_t m_maxUs = 0;
+};
+
+/// @brief Collects the per stage latencies of the presented camera frames, and counts the dropped and late ones
+class CameraLatencyStats
+{
+public:
+  enum class Stage{CAPTURE_TO_CONVERT = 0, CONVERT_TO_UPLOAD, UPLOAD_TO_PRESENT, CAPTURE_TO_PRESENT, COUNT};
+  CameraLatencyStats() = default;
+  // has to be called once per displayed frame after the swapchain present, repeated frames are ignored
+  void OnFramePresented(const FrameTimestamps& timestamps, FrameClock::time_point presented);
+  void SetFrameBudget(FrameClock::duration budget){m_frameBudget = budget;}
+  void Reset();
+
+  const LatencyHistogram& GetHistogram(Stage stage) const {return m_histograms[static_cast<size_t>(stage)];}
+  uint64_t GetPresentedFrames() const {return m_presentedFrames;}
+  uint64_t GetDroppedFrames() const {return m_droppedFrames;}
+  uint64_t GetLateFrames() const {return m_lateFrames;}
+  bool ExportJson(const std::filesystem::path& path) const;
+  static const char* GetStageName(Stage stage);
+private:
+  std::array<LatencyHistogram, static_cast<size_t>(Stage::COUNT)> m_histograms;
+  FrameClock::duration m_frameBudget = std::chrono::milliseconds(66); // two frames at 30 fps
+  uint64_t m_lastPresentedSequence = 0;
+  uint64_t m_presentedFrames = 0;
+  uint64_t m_droppedFrames = 0;
+  uint64_t m_lateFrames = 0;
+};
+
+} // namespace medicimage
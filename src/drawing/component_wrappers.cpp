@@ -1,43 +1,57 @@
 #include "drawing/component_wrappers.h"
+#include "drawing/hit_testing.h"
 #include "image_handling/image_editor.h"
 #include "core/log.h"
 #include "component_wrappers.h"
 
 namespace medicimage
 {
-  Entity RectangleComponentWrapper::CreateRectangle(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
+  void BaseDrawComponentWrapper::SetBoundingContour(std::initializer_list<glm::vec2> points)
   {
-    auto entity = Entity::CreateEntity(0, "rectangle");
+    if(!m_entity.HasComponent<BoundingContourComponent>())
+      m_entity.AddComponent<BoundingContourComponent>();
+    m_entity.Patch<BoundingContourComponent>([points](auto& boundingContour) { boundingContour.SetPoints(points); });
+  }
+
+  void BaseDrawComponentWrapper::Translate(glm::vec2 diff)
+  {
+    m_entity.Patch<TransformComponent>([diff](auto& transform) { transform.translation += diff; });
+  }
+
+  Entity RectangleComponentWrapper::CreateRectangle(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
+  {
+    auto entity = Entity::CreateEntity(registry, 0, "rectangle");
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
-    auto& transform = entity.GetComponent<TransformComponent>();
     auto& color = entity.AddComponent<ColorComponent>();  
     auto& rectangle = entity.AddComponent<RectangleComponent>();
     auto& thickness = entity.AddComponent<ThicknessComponent>();
+    RectangleComponentWrapper(entity).SetPoints(firstPoint, secondPoint);
+    return entity;
+  }
 
+  void RectangleComponentWrapper::SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint)
+  {
     auto tmpRect = cv::Rect2f(cv::Point2f{ firstPoint.x, firstPoint.y }, cv::Point2f{ secondPoint.x, secondPoint.y });
+    auto& rectangle = m_entity.GetComponent<RectangleComponent>();
     rectangle.width = tmpRect.width;
     rectangle.height = tmpRect.height; 
 
     glm::vec2 topleft{tmpRect.tl().x, tmpRect.tl().y};
-    transform.translation = topleft;
-    return entity;
+    m_entity.Patch<TransformComponent>([topleft](auto& transform) { transform.translation = topleft; });
   }
 
   void RectangleComponentWrapper::UpdateShapeAttributes()
   {
     auto& rectangle = m_entity.GetComponent<RectangleComponent>();
-    if(!m_entity.HasComponent<BoundingContourComponent>())
-      m_entity.AddComponent<BoundingContourComponent>();
     if(!m_entity.HasComponent<PickPointsComponent>())
       m_entity.AddComponent<PickPointsComponent>();
 
-    auto& boundingBox = m_entity.GetComponent<BoundingContourComponent>();
     auto& pickPoints = m_entity.GetComponent<PickPointsComponent>();
     
-    boundingBox.cornerPoints = {{0,0}, {rectangle.width, 0}, {rectangle.width, rectangle.height}, {0, rectangle.height}, {0,0}};
     pickPoints.pickPoints = {glm::vec2{rectangle.width, rectangle.height} + glm::vec2{0, -rectangle.height / 2},
       glm::vec2{rectangle.width, rectangle.height} + glm::vec2{-rectangle.width / 2, 0}, {0, rectangle.height / 2}, glm::vec2{rectangle.width / 2, 0}};
+    SetBoundingContour({{0,0}, {rectangle.width, 0}, {rectangle.width, rectangle.height}, {0, rectangle.height}, {0,0}});
   }
 
   void RectangleComponentWrapper::OnPickPointDrag(glm::vec2 diff, int selectedPoint)
@@ -57,13 +71,13 @@ namespace medicimage
       case static_cast<int>(RectanglePicPoints::LEFT):
       {
         m_entity.GetComponent<RectangleComponent>().width += -diff.x;
-        m_entity.GetComponent<TransformComponent>().translation += glm::vec2{diff.x, 0};
+        Translate(glm::vec2{diff.x, 0});
         break;
       }
       case static_cast<int>(RectanglePicPoints::TOP):
       {
         m_entity.GetComponent<RectangleComponent>().height += -diff.y;
-        m_entity.GetComponent<TransformComponent>().translation += glm::vec2{0, diff.y};
+        Translate(glm::vec2{0, diff.y});
         break;
       }
       default:
@@ -76,8 +90,7 @@ namespace medicimage
   void RectangleComponentWrapper::OnObjectDrag(glm::vec2 diff)
   {
     // TODO: some checks wether we drag the component outside or not etc..
-    auto& transform = m_entity.GetComponent<TransformComponent>();
-    transform.translation += diff;
+    Translate(diff);
   }
 
   void RectangleComponentWrapper::Draw()
@@ -91,7 +104,7 @@ namespace medicimage
     auto bottomright = topleft + glm::vec2{rectangle.width, rectangle.height}; 
     ImageEditor::DrawRectangle(topleft, bottomright, color, thickness.thickness, commonAttributes.filled);
     
-    if(commonAttributes.selected)
+    if(m_entity.HasComponent<SelectedTag>())
     {
       auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
       for(auto& point : pickPoints)
@@ -101,40 +114,41 @@ namespace medicimage
     }
   }
 
-  Entity medicimage::CircleComponentWrapper::CreateCircle(glm::vec2 firstPoint, glm::vec2 secondPoint, float aspectRatio, DrawObjectType objectType)
+  Entity medicimage::CircleComponentWrapper::CreateCircle(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, float aspectRatio, DrawObjectType objectType)
   {
-    auto entity = Entity::CreateEntity(0, "Circle");
+    auto entity = Entity::CreateEntity(registry, 0, "Circle");
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
-    auto& transform = entity.GetComponent<TransformComponent>();
-    transform.translation = firstPoint;
-
     auto& color = entity.AddComponent<ColorComponent>();  
     auto& circle = entity.AddComponent<CircleComponent>();
     auto& thickness = entity.AddComponent<ThicknessComponent>();
-    circle.radius = glm::length(firstPoint - secondPoint);
-    circle.aspectRatio = aspectRatio;
+    CircleComponentWrapper(entity).SetPoints(firstPoint, secondPoint, aspectRatio);
 
     return entity;
   }
 
+  void CircleComponentWrapper::SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint, float aspectRatio)
+  {
+    m_entity.Patch<TransformComponent>([firstPoint](auto& transform) { transform.translation = firstPoint; });
+    auto& circle = m_entity.GetComponent<CircleComponent>();
+    circle.radius = glm::length(firstPoint - secondPoint);
+    circle.aspectRatio = aspectRatio;
+  }
+
   void CircleComponentWrapper::UpdateShapeAttributes()
   {
     auto& circle = m_entity.GetComponent<CircleComponent>();
     
-    if(!m_entity.HasComponent<BoundingContourComponent>())
-      m_entity.AddComponent<BoundingContourComponent>();
     if(!m_entity.HasComponent<PickPointsComponent>())
       m_entity.AddComponent<PickPointsComponent>();
     
-    auto& boundingBox = m_entity.GetComponent<BoundingContourComponent>();
     auto& pickPoints = m_entity.GetComponent<PickPointsComponent>();
     // bounding polyigon of the circle is a square actually
     float aspectRatio = circle.aspectRatio;
     float radius = circle.radius;
     // need to scale the y component, because the aspect ratio is not 1:1
-    boundingBox.cornerPoints = {{-radius, -radius * aspectRatio}, {radius, -radius * aspectRatio}, {radius, radius * aspectRatio}, {-radius, radius * aspectRatio}, {0,0}};
     pickPoints.pickPoints = {{radius, 0}, {0, radius * aspectRatio}, {-radius, 0}, {0, -radius * aspectRatio}};
+    SetBoundingContour({{-radius, -radius * aspectRatio}, {radius, -radius * aspectRatio}, {radius, radius * aspectRatio}, {-radius, radius * aspectRatio}, {0,0}});
   }
 
   void CircleComponentWrapper::OnPickPointDrag(glm::vec2 diff, int selectedPoint)
@@ -177,8 +191,7 @@ namespace medicimage
   void CircleComponentWrapper::OnObjectDrag(glm::vec2 diff)
   {
     // TODO: some checks wether we drag the component outside or not etc..
-    auto& transform = m_entity.GetComponent<TransformComponent>();
-    transform.translation += diff;
+    Translate(diff);
   }
  
   void CircleComponentWrapper::Draw()
@@ -191,7 +204,7 @@ namespace medicimage
     auto& center = transform.translation;
     ImageEditor::DrawCircle(center, circle.radius, color, thickness.thickness, commonAttributes.filled);
 
-    if(commonAttributes.selected)
+    if(m_entity.HasComponent<SelectedTag>())
     {
       auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
       auto& translation = m_entity.GetComponent<TransformComponent>().translation;
@@ -203,38 +216,41 @@ namespace medicimage
     } 
   }
 
-  Entity ArrowComponentWrapper::CreateArrow(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
+  Entity ArrowComponentWrapper::CreateArrow(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
   {
-    auto entity = Entity::CreateEntity(0, "Arrow");
+    auto entity = Entity::CreateEntity(registry, 0, "Arrow");
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
-    auto& transform = entity.GetComponent<TransformComponent>();
-    transform.translation = firstPoint;
-
     auto& color = entity.AddComponent<ColorComponent>();  
     auto& arrow = entity.AddComponent<ArrowComponent>();
     auto& thickness = entity.AddComponent<ThicknessComponent>();
-    arrow.end = secondPoint - firstPoint;
+    ArrowComponentWrapper(entity).SetPoints(firstPoint, secondPoint);
 
     return entity;
   }
 
+  void ArrowComponentWrapper::SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint)
+  {
+    m_entity.Patch<TransformComponent>([firstPoint](auto& transform) { transform.translation = firstPoint; });
+    auto& arrow = m_entity.GetComponent<ArrowComponent>();
+    arrow.begin = {0.0f, 0.0f};
+    arrow.end = secondPoint - firstPoint;
+  }
+
   void ArrowComponentWrapper::UpdateShapeAttributes()
   {
     auto& arrow = m_entity.GetComponent<ArrowComponent>();
 
-    if(!m_entity.HasComponent<BoundingContourComponent>())
-      m_entity.AddComponent<BoundingContourComponent>();
     if(!m_entity.HasComponent<PickPointsComponent>())
       m_entity.AddComponent<PickPointsComponent>();
-    auto& boundingBox = m_entity.GetComponent<BoundingContourComponent>();
     auto& pickPoints = m_entity.GetComponent<PickPointsComponent>();
 
     glm::vec2 vec = arrow.begin - arrow.end; 
     glm::vec2 perp = glm::normalize(glm::vec2{-vec.y, vec.x});
     glm::vec2 offset = perp * glm::vec2(0.01);
-    boundingBox.cornerPoints = {offset, arrow.end + offset, arrow.end - offset, -offset, offset};
     pickPoints.pickPoints = {arrow.begin, arrow.end};
+    // the begin is not at the translation after its pickpoint was dragged
+    SetBoundingContour({arrow.begin + offset, arrow.end + offset, arrow.end - offset, arrow.begin - offset, arrow.begin + offset});
   }
 
   void ArrowComponentWrapper::OnPickPointDrag(glm::vec2 diff, int selectedPoint)
@@ -257,14 +273,12 @@ namespace medicimage
   void ArrowComponentWrapper::OnObjectDrag(glm::vec2 diff)
   {
     // TODO: some checks wether we drag the component outside or not etc..
-    auto& transform = m_entity.GetComponent<TransformComponent>();
-    transform.translation += diff;
+    Translate(diff);
   }
   
   void ArrowComponentWrapper::Draw()
   {
     auto& transform  = m_entity.GetComponent<TransformComponent>();
-    auto& commonAttributes = m_entity.GetComponent<CommonAttributesComponent>();
     auto& arrow = m_entity.GetComponent<ArrowComponent>();
     auto& color = m_entity.GetComponent<ColorComponent>().color;
     auto& thickness = m_entity.GetComponent<ThicknessComponent>();
@@ -272,7 +286,7 @@ namespace medicimage
     auto end = arrow.end + transform.translation; 
     ImageEditor::DrawArrow(begin, end, color, thickness.thickness, 0.1);
     
-    if(commonAttributes.selected)
+    if(m_entity.HasComponent<SelectedTag>())
     {
       auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
       for(auto& point : pickPoints)
@@ -282,38 +296,41 @@ namespace medicimage
     }
   }
   
-  Entity LineComponentWrapper::CreateLine(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
+  Entity LineComponentWrapper::CreateLine(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
   {
-    auto entity = Entity::CreateEntity(0, "Line");
+    auto entity = Entity::CreateEntity(registry, 0, "Line");
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
-    auto& transform = entity.GetComponent<TransformComponent>();
-    transform.translation = firstPoint;
-
     auto& color = entity.AddComponent<ColorComponent>();  
     auto& line = entity.AddComponent<LineComponent>();
     auto& thickness = entity.AddComponent<ThicknessComponent>();
-    line.end = secondPoint - firstPoint;
+    LineComponentWrapper(entity).SetPoints(firstPoint, secondPoint);
 
     return entity;
   }
 
+  void LineComponentWrapper::SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint)
+  {
+    m_entity.Patch<TransformComponent>([firstPoint](auto& transform) { transform.translation = firstPoint; });
+    auto& line = m_entity.GetComponent<LineComponent>();
+    line.begin = {0.0f, 0.0f};
+    line.end = secondPoint - firstPoint;
+  }
+
   void LineComponentWrapper::UpdateShapeAttributes()
   {
     auto& line = m_entity.GetComponent<LineComponent>();
 
-    if(!m_entity.HasComponent<BoundingContourComponent>())
-      m_entity.AddComponent<BoundingContourComponent>();
     if(!m_entity.HasComponent<PickPointsComponent>())
       m_entity.AddComponent<PickPointsComponent>();
-    auto& boundingBox = m_entity.GetComponent<BoundingContourComponent>();
     auto& pickPoints = m_entity.GetComponent<PickPointsComponent>();
 
     glm::vec2 vec = line.begin - line.end; 
     glm::vec2 perp = glm::normalize(glm::vec2{-vec.y, vec.x});
     glm::vec2 offset = perp * glm::vec2(0.01);
-    boundingBox.cornerPoints = {offset, line.end + offset, line.end - offset, -offset, offset};
     pickPoints.pickPoints = {line.begin, line.end};
+    // the begin is not at the translation after its pickpoint was dragged
+    SetBoundingContour({line.begin + offset, line.end + offset, line.end - offset, line.begin - offset, line.begin + offset});
   }
 
   void LineComponentWrapper::OnPickPointDrag(glm::vec2 diff, int selectedPoint)
@@ -336,14 +353,12 @@ namespace medicimage
   void LineComponentWrapper::OnObjectDrag(glm::vec2 diff)
   {
     // TODO: some checks wether we drag the component outside or not etc..
-    auto& transform = m_entity.GetComponent<TransformComponent>();
-    transform.translation += diff;
+    Translate(diff);
   }
 
   void LineComponentWrapper::Draw()
   {
     auto& transform  = m_entity.GetComponent<TransformComponent>();
-    auto& commonAttributes = m_entity.GetComponent<CommonAttributesComponent>();
     auto& line = m_entity.GetComponent<LineComponent>();
     auto& color = m_entity.GetComponent<ColorComponent>().color;
     auto& thickness = m_entity.GetComponent<ThicknessComponent>();
@@ -351,7 +366,7 @@ namespace medicimage
     auto end = line.end + transform.translation; 
     ImageEditor::DrawLine(begin, end, color, thickness.thickness, 0.1);
     
-    if(commonAttributes.selected)
+    if(m_entity.HasComponent<SelectedTag>())
     {
       auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
       for(auto& point : pickPoints)
@@ -361,9 +376,175 @@ namespace medicimage
     }
   }
   
-  Entity TextComponentWrapper::CreateText(glm::vec2 firstPoint, const std::string& inputText, int fontSize, DrawObjectType objectType)
+  Entity PolylineComponentWrapper::CreatePolyline(entt::registry& registry, std::span<const glm::vec2> points, DrawObjectType objectType)
+  {
+    assert(!points.empty());
+    auto entity = Entity::CreateEntity(registry, 0, "Polyline");
+    entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
+
+    auto& color = entity.AddComponent<ColorComponent>();  
+    auto& thickness = entity.AddComponent<ThicknessComponent>();
+    const glm::vec2 origin = points.front();
+    entity.Patch<TransformComponent>([origin](auto& transform) { transform.translation = origin; });
+    auto& polyline = entity.AddComponent<PolylineComponent>();
+    polyline.points.reserve(points.size());
+    for(const auto& point : points)
+      polyline.points.push_back(point - origin);
+    PolylineComponentWrapper(entity).UpdateShapeAttributes();
+    return entity;
+  }
+
+  void PolylineComponentWrapper::AddPoint(glm::vec2 point)
+  {
+    auto& points = m_entity.GetComponent<PolylineComponent>().points;
+    const glm::vec2 relativePoint = point - m_entity.GetComponent<TransformComponent>().translation;
+    if(!points.empty() && points.back() == relativePoint)
+      return;
+    points.push_back(relativePoint);
+
+    // a freehand stroke gets a point on every mouse event, so nothing is recomputed from the whole outline here
+    auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
+    if(points.size() <= s_maxVertexPickPoints)
+      pickPoints.push_back(relativePoint);
+    else if(pickPoints.size() != 2)
+      pickPoints = {points.front(), relativePoint};
+    else
+      pickPoints.back() = relativePoint;
+    const auto& contour = m_entity.GetComponent<BoundingContourComponent>();
+    SetBounds(glm::min(contour.min, relativePoint - s_contourOffset), glm::max(contour.max, relativePoint + s_contourOffset));
+  }
+
+  void PolylineComponentWrapper::Simplify(float tolerance)
+  {
+    auto& points = m_entity.GetComponent<PolylineComponent>().points;
+    if(tolerance <= 0.0f || points.size() < 3)
+      return;
+    // the ranges are processed with an explicit stack, an outline can have thousands of points
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = true;
+    keep.back() = true;
+    std::vector<std::pair<size_t, size_t>> ranges{{0, points.size() - 1}};
+    while(!ranges.empty())
+    {
+      const auto [first, last] = ranges.back();
+      ranges.pop_back();
+      float maxDistance = 0.0f;
+      size_t farthest = first;
+      for(size_t i = first + 1; i < last; i++)
+      {
+        const float distance = HitTesting::SegmentDistance(points[first], points[last], points[i]);
+        if(distance > maxDistance)
+        {
+          maxDistance = distance;
+          farthest = i;
+        }
+      }
+      if(maxDistance > tolerance)
+      {
+        keep[farthest] = true;
+        ranges.push_back({first, farthest});
+        ranges.push_back({farthest, last});
+      }
+    }
+
+    size_t count = 0;
+    for(size_t i = 0; i < points.size(); i++)
+    {
+      if(keep[i])
+        points[count++] = points[i];
+    }
+    if(count == points.size())
+      return;
+    points.resize(count);
+    UpdateShapeAttributes();
+  }
+
+  void PolylineComponentWrapper::UpdateShapeAttributes()
+  {
+    const auto& points = m_entity.GetComponent<PolylineComponent>().points;
+    if(!m_entity.HasComponent<PickPointsComponent>())
+      m_entity.AddComponent<PickPointsComponent>();
+    auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
+    if(points.size() <= s_maxVertexPickPoints)
+      pickPoints = points;
+    else
+      pickPoints = {points.front(), points.back()};
+
+    // a single box around the vertices, offset like the line's contour, the segments are tested by the hit testing
+    glm::vec2 min = points.empty() ? glm::vec2{0.0f, 0.0f} : points.front();
+    glm::vec2 max = min;
+    for(const auto& point : points)
+    {
+      min = glm::min(min, point);
+      max = glm::max(max, point);
+    }
+    SetBounds(min - s_contourOffset, max + s_contourOffset);
+  }
+
+  void PolylineComponentWrapper::SetBounds(glm::vec2 min, glm::vec2 max)
+  {
+    SetBoundingContour({min, {max.x, min.y}, max, {min.x, max.y}, min});
+  }
+
+  size_t PolylineComponentWrapper::GetPickedVertex(int selectedPoint)
+  {
+    const auto& points = m_entity.GetComponent<PolylineComponent>().points;
+    if(points.size() > s_maxVertexPickPoints && selectedPoint == 1)
+      return points.size() - 1;
+    return static_cast<size_t>(selectedPoint);
+  }
+
+  void PolylineComponentWrapper::OnPickPointDrag(glm::vec2 diff, int selectedPoint)
+  {
+    auto& points = m_entity.GetComponent<PolylineComponent>().points;
+    const auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
+    if(selectedPoint < 0 || selectedPoint >= static_cast<int>(pickPoints.size()))
+    {
+      APP_CORE_ERR("Wrong pickpoint index({}) at component:{}", selectedPoint, m_entity.GetComponent<IDComponent>().ID);
+      return;
+    }
+    points[GetPickedVertex(selectedPoint)] += diff;
+    UpdateShapeAttributes();
+  }
+
+  void PolylineComponentWrapper::OnObjectDrag(glm::vec2 diff)
+  {
+    Translate(diff);
+  }
+
+  void PolylineComponentWrapper::Draw()
   {
-    auto entity = Entity::CreateEntity(0, "Text");
+    auto& transform  = m_entity.GetComponent<TransformComponent>();
+    auto& polyline = m_entity.GetComponent<PolylineComponent>();
+    auto& color = m_entity.GetComponent<ColorComponent>().color;
+    auto& thickness = m_entity.GetComponent<ThicknessComponent>();
+    ImageEditor::DrawPolyline(polyline.points, transform.translation, color, thickness.thickness);
+
+    if(m_entity.HasComponent<SelectedTag>())
+    {
+      auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
+      for(auto& point : pickPoints)
+      {
+        ImageEditor::DrawCircle(point + transform.translation, s_pickPointBoxSize / 2, s_pickPointColor, 2, true);
+      }
+    }
+  }
+
+  void PolylineComponentWrapper::DrawFrom(size_t firstPoint)
+  {
+    const auto& points = m_entity.GetComponent<PolylineComponent>().points;
+    if(firstPoint >= points.size())
+      return;
+    // the previous vertex is included, so the new segments connect to the already drawn ones
+    const size_t first = firstPoint > 0 ? firstPoint - 1 : 0;
+    auto& color = m_entity.GetComponent<ColorComponent>().color;
+    auto& thickness = m_entity.GetComponent<ThicknessComponent>();
+    ImageEditor::DrawPolyline(std::span(points).subspan(first), m_entity.GetComponent<TransformComponent>().translation, color, thickness.thickness);
+  }
+
+  Entity TextComponentWrapper::CreateText(entt::registry& registry, glm::vec2 firstPoint, const std::string& inputText, int fontSize, DrawObjectType objectType)
+  {
+    auto entity = Entity::CreateEntity(registry, 0, "Text");
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
     auto& transform = entity.GetComponent<TransformComponent>();
@@ -380,51 +561,55 @@ namespace medicimage
   void TextComponentWrapper::UpdateShapeAttributes()
   {
     auto& text = m_entity.GetComponent<TextComponent>();
-    if(!m_entity.HasComponent<BoundingContourComponent>())
-      m_entity.AddComponent<BoundingContourComponent>();
     if(!m_entity.HasComponent<PickPointsComponent>())
       m_entity.AddComponent<PickPointsComponent>();
 
-    auto textSize = ImageEditor::GetTextBoundingBox(text.text, text.fontSize, 5.0);  // TODO: add thickness component
-    auto& boundingBox = m_entity.GetComponent<BoundingContourComponent>();
+    text.boxSize = GetLayout().boxSize;
+    const auto textSize = text.boxSize;
     auto& pickPoints = m_entity.GetComponent<PickPointsComponent>();
-    boundingBox.cornerPoints = {{0,0}, {textSize.x, 0}, {textSize.x, -textSize.y}, {0, -textSize.y}, {0,0}};
     pickPoints.pickPoints = {{0,0}, {textSize.x, 0}, {textSize.x, -textSize.y}, {0, -textSize.y}};  
+    SetBoundingContour({{0,0}, {textSize.x, 0}, {textSize.x, -textSize.y}, {0, -textSize.y}, {0,0}});
   }
 
   void TextComponentWrapper::OnObjectDrag(glm::vec2 diff)
   {
     // TODO: some checks wether we drag the component outside or not etc..
-    auto& transform = m_entity.GetComponent<TransformComponent>();
-    transform.translation += diff;
+    Translate(diff);
   }
 
   void TextComponentWrapper::Draw()
   {
     auto& transform  = m_entity.GetComponent<TransformComponent>();
-    auto& commonAttributes = m_entity.GetComponent<CommonAttributesComponent>();
-    auto& thickness = m_entity.GetComponent<ThicknessComponent>();
+    ImageEditor::DrawText(transform.translation, GetLayout());
+  }
+
+  const TextLayout& TextComponentWrapper::GetLayout()
+  {
     auto& text = m_entity.GetComponent<TextComponent>();
-    ImageEditor::DrawText(transform.translation, text.text, text.fontSize, thickness.thickness); // TODO: add thickness component
+    return ImageEditor::GetTextLayout(text.layout, text.text, text.fontSize);
   }
 
-  Entity SplineComponentWrapper::CreateSpline(glm::vec2 begin, glm::vec2 middle, glm::vec2 end, DrawObjectType objectType)
+  Entity SplineComponentWrapper::CreateSpline(entt::registry& registry, glm::vec2 begin, glm::vec2 middle, glm::vec2 end, DrawObjectType objectType)
   {
-    auto entity = Entity::CreateEntity(0, "Spline");
+    auto entity = Entity::CreateEntity(registry, 0, "Spline");
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
-    auto& transform = entity.GetComponent<TransformComponent>();
-    transform.translation = begin;
-
     auto& color = entity.AddComponent<ColorComponent>();  
     auto& spline = entity.AddComponent<SplineComponent>();
     auto& thickness = entity.AddComponent<ThicknessComponent>();
     color.color = {0.0, 0.0, 0.0, 1.0};
+    SplineComponentWrapper(entity).SetPoints(begin, middle, end);
+    return entity;
+  }
+
+  void SplineComponentWrapper::SetPoints(glm::vec2 begin, glm::vec2 middle, glm::vec2 end)
+  {
+    m_entity.Patch<TransformComponent>([begin](auto& transform) { transform.translation = begin; });
+    auto& spline = m_entity.GetComponent<SplineComponent>();
     spline.begin = {0.0,0.0};
     spline.middle = middle - begin;
     spline.end = end - begin;
     spline.lineCount = static_cast<int>(glm::length(end - begin) / 0.01);
-    return entity;
   }
 
   void SplineComponentWrapper::Draw()
@@ -442,25 +627,33 @@ namespace medicimage
     
   }
 
-  Entity SkinTemplateComponentWrapper::CreateSkinTemplate(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
+  Entity SkinTemplateComponentWrapper::CreateSkinTemplate(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType)
   {
-    auto entity = Entity::CreateEntity(0, "Skin template");
+    auto entity = Entity::CreateEntity(registry, 0, "Skin template");
 
     entity.GetComponent<CommonAttributesComponent>().temporary = objectType == DrawObjectType::TEMPORARY ? true : false;
     
-    auto& transform = entity.GetComponent<TransformComponent>();
-    transform.translation = firstPoint;
     auto& skinTemplate = entity.AddComponent<SkinTemplateComponent>();
     auto& thickness = entity.AddComponent<ThicknessComponent>();
     auto& color = entity.AddComponent<ColorComponent>();  
+    SkinTemplateComponentWrapper(entity).SetPoints(firstPoint, secondPoint);
+    return entity;
+  }
+
+  void SkinTemplateComponentWrapper::SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint)
+  {
+    m_entity.Patch<TransformComponent>([firstPoint](auto& transform) { transform.translation = firstPoint; });
+    auto& skinTemplate = m_entity.GetComponent<SkinTemplateComponent>();
 
     static constexpr float minBoundingWidth = 0.1;
     static constexpr float minBoundingHeight = 0.1;
     auto diff = secondPoint - firstPoint;
+    // a template below the minimum size is kept while it is dragged, but it has no slices;
+    // the size follows the drag even then, so the contour does not stay at an earlier, larger size
+    skinTemplate.drawable = false;
+    skinTemplate.boundingRectSize = glm::abs(diff);
     if(abs(diff.x) >= minBoundingWidth && abs(diff.y) >= minBoundingHeight)
     {
-      auto boundingRectSize = glm::abs(diff);
-      skinTemplate.boundingRectSize = glm::abs(diff);
       skinTemplate.leftHorSliceCount = s_defaultHorizontalCount;
       skinTemplate.rightHorSliceCount = s_defaultHorizontalCount;
       skinTemplate.vertSliceCount = s_defaultVerticalCount;
@@ -473,14 +666,19 @@ namespace medicimage
       // check the vertical slice width and horizontal height
       auto verticalSliceWidth = skinTemplate.vertSliceWidthSpan  * skinTemplate.boundingRectSize.x / s_defaultVerticalCount;
       auto horizontalSliceHeight =  skinTemplate.leftHorSliceHeightSpan * skinTemplate.boundingRectSize.y / s_defaultHorizontalCount; 
-      auto horizontalSliceWidth = (1 - skinTemplate.vertSliceWidthSpan) / 2 * skinTemplate.boundingRectSize.x;
       assert(verticalSliceWidth > s_minimumSliceSize);
       assert(horizontalSliceHeight > s_minimumSliceSize);
 
       skinTemplate.drawable = true;
-      GenerateSlices(entity);
     }
-    return entity;
+    // the slices are generated once, by the UpdateShapeAttributes following every SetPoints
+  }
+
+  void SkinTemplateComponentWrapper::DestroySlices()
+  {
+    auto& skinTemplate = m_entity.GetComponent<SkinTemplateComponent>();
+    skinTemplate.drawable = false;
+    GenerateSlices(m_entity);
   }
 
   void SkinTemplateComponentWrapper::GenerateSlices(Entity entity)
@@ -488,100 +686,87 @@ namespace medicimage
     auto& transform = entity.GetComponent<TransformComponent>();
     auto& skinTemplate = entity.GetComponent<SkinTemplateComponent>();
 
-    if(skinTemplate.drawable == true)
-    {
-      // clear the current rectangles, because we will generate the new ones according to the number of slices and the vertical/horizontal sizes
-      for(auto e : skinTemplate.leftHorizontalSlices)
-      {
-        Entity::DestroyEntity(Entity(e));
-      }
-      skinTemplate.leftHorizontalSlices.clear();
-      for(auto e : skinTemplate.rightHorizontalSlices)
-      {
-        Entity::DestroyEntity(Entity(e));
-      }
-      skinTemplate.rightHorizontalSlices.clear();
-      for(auto e : skinTemplate.verticalSlices)
-      {
-        Entity::DestroyEntity(Entity(e));
-      }
-      skinTemplate.verticalSlices.clear();
-    
-      for(auto e : skinTemplate.splines)
-      {
-        Entity::DestroyEntity(Entity(e));
-      }
-      skinTemplate.splines.clear();
-
-      // check the sizes
-      auto& color = entity.GetComponent<ColorComponent>();
-      auto objectType = entity.GetComponent<CommonAttributesComponent>().temporary ? DrawObjectType::TEMPORARY : DrawObjectType::PERMANENT;
-      auto verticalStartPoint = transform.translation + glm::vec2{skinTemplate.boundingRectSize.x * skinTemplate.leftHorSliceWidthSpan, 0.0};
-      auto leftHorStartPoint = transform.translation + glm::vec2{0.0, (1 - skinTemplate.leftHorSliceHeightSpan) / 2 * skinTemplate.boundingRectSize.y};
-      auto rightHorStartPoint = transform.translation + 
-        glm::vec2{skinTemplate.boundingRectSize.x * (skinTemplate.leftHorSliceWidthSpan + skinTemplate.vertSliceWidthSpan), (1 - skinTemplate.rightHorSliceHeightSpan) / 2 * skinTemplate.boundingRectSize.y};
-      for (auto i = 0; i < skinTemplate.vertSliceCount; i++)
+    // the slices are updated in place, entities are only created or destroyed when the slice counts change,
+    // a template which is not drawable has none of them
+    const bool drawable = skinTemplate.drawable;
+    auto& color = entity.GetComponent<ColorComponent>();
+    auto& thickness = entity.GetComponent<ThicknessComponent>();
+    auto objectType = entity.GetComponent<CommonAttributesComponent>().temporary ? DrawObjectType::TEMPORARY : DrawObjectType::PERMANENT;
+    auto resizeSlices = [&](std::vector<entt::entity>& slices, int count, auto createSlice) {
+      while(static_cast<int>(slices.size()) > count)
       {
-        glm::vec2 sliceSize{skinTemplate.vertSliceWidthSpan / skinTemplate.vertSliceCount * skinTemplate.boundingRectSize.x, skinTemplate.boundingRectSize.y};
-
-        glm::vec2 vertTopLeft =  verticalStartPoint + glm::vec2{ i * sliceSize.x, 0.0};
-        glm::vec2 vertBottomRight = verticalStartPoint + glm::vec2{ (i + 1) * sliceSize.x, sliceSize.y};
-        auto rect = RectangleComponentWrapper::CreateRectangle(vertTopLeft, vertBottomRight, objectType);
-        rect.GetComponent<ColorComponent>() = color; 
-        rect.GetComponent<CommonAttributesComponent>().composed = true;
-        rect.GetComponent<ThicknessComponent>() = entity.GetComponent<ThicknessComponent>();
-        skinTemplate.verticalSlices.push_back(rect.GetHandle());
+        Entity::DestroyEntity(entity.FromHandle(slices.back()));
+        slices.pop_back();
       }
-      for (auto i = 0; i < skinTemplate.leftHorSliceCount; i++)
+      while(static_cast<int>(slices.size()) < count)
       {
-        float sliceWidth = skinTemplate.leftHorSliceWidthSpan * skinTemplate.boundingRectSize.x;
-        float sliceHeight = skinTemplate.leftHorSliceHeightSpan / skinTemplate.leftHorSliceCount * skinTemplate.boundingRectSize.y;
-
-        glm::vec2 horTopLeft = leftHorStartPoint + glm::vec2{0.0, i * sliceHeight};
-        glm::vec2 horBottomRight = leftHorStartPoint + glm::vec2{sliceWidth, (i + 1) * sliceHeight};
-        auto rect = RectangleComponentWrapper::CreateRectangle(horTopLeft, horBottomRight, objectType);
-        rect.GetComponent<ColorComponent>() = color; 
-        rect.GetComponent<CommonAttributesComponent>().composed = true;
-        rect.GetComponent<ThicknessComponent>() = entity.GetComponent<ThicknessComponent>();
-        skinTemplate.leftHorizontalSlices.push_back(rect.GetHandle());
+        auto slice = createSlice();
+        slice.GetComponent<CommonAttributesComponent>().composed = true;
+        slices.push_back(slice.GetHandle());
       }
+    };
+    auto createRectangle = [&]() { return RectangleComponentWrapper::CreateRectangle(*entity.GetRegistry(), {0.0, 0.0}, {0.0, 0.0}, objectType); };
+    auto updateRectangle = [&](entt::entity e, glm::vec2 topLeft, glm::vec2 bottomRight) {
+      Entity rect = entity.FromHandle(e);
+      RectangleComponentWrapper(rect).SetPoints(topLeft, bottomRight);
+      rect.GetComponent<ColorComponent>() = color; 
+      rect.GetComponent<ThicknessComponent>() = thickness;
+    };
 
-      for (auto i = 0; i < skinTemplate.rightHorSliceCount; i++)
-      {
-        float sliceWidth = skinTemplate.rightHorSliceWidthSpan * skinTemplate.boundingRectSize.x;
-        float sliceHeight = skinTemplate.rightHorSliceHeightSpan / skinTemplate.rightHorSliceCount * skinTemplate.boundingRectSize.y;
-
-        glm::vec2 horTopLeft = rightHorStartPoint + glm::vec2{0.0, i * sliceHeight};
-        glm::vec2 horBottomRight = rightHorStartPoint + glm::vec2{sliceWidth, (i + 1) * sliceHeight};
-        auto rect = RectangleComponentWrapper::CreateRectangle(horTopLeft, horBottomRight, objectType);
-        rect.GetComponent<ColorComponent>() = color; 
-        rect.GetComponent<CommonAttributesComponent>().composed = true;
-        rect.GetComponent<ThicknessComponent>() = entity.GetComponent<ThicknessComponent>();
-        skinTemplate.rightHorizontalSlices.push_back(rect.GetHandle());
-      }
+    auto createSpline = [&]() -> Entity
+    {
+      return SplineComponentWrapper::CreateSpline(*entity.GetRegistry(), {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}, objectType);
+    };
+    resizeSlices(skinTemplate.verticalSlices, drawable ? skinTemplate.vertSliceCount : 0, createRectangle);
+    resizeSlices(skinTemplate.leftHorizontalSlices, drawable ? skinTemplate.leftHorSliceCount : 0, createRectangle);
+    resizeSlices(skinTemplate.rightHorizontalSlices, drawable ? skinTemplate.rightHorSliceCount : 0, createRectangle);
+    resizeSlices(skinTemplate.splines, drawable && skinTemplate.drawSpline ? 2 : 0, createSpline);
+    if(!drawable)
+      return;
+
+    auto verticalStartPoint = transform.translation + glm::vec2{skinTemplate.boundingRectSize.x * skinTemplate.leftHorSliceWidthSpan, 0.0};
+    auto leftHorStartPoint = transform.translation + glm::vec2{0.0, (1 - skinTemplate.leftHorSliceHeightSpan) / 2 * skinTemplate.boundingRectSize.y};
+    auto rightHorStartPoint = transform.translation + 
+      glm::vec2{skinTemplate.boundingRectSize.x * (skinTemplate.leftHorSliceWidthSpan + skinTemplate.vertSliceWidthSpan), (1 - skinTemplate.rightHorSliceHeightSpan) / 2 * skinTemplate.boundingRectSize.y};
+    for (auto i = 0; i < skinTemplate.vertSliceCount; i++)
+    {
+      glm::vec2 sliceSize{skinTemplate.vertSliceWidthSpan / skinTemplate.vertSliceCount * skinTemplate.boundingRectSize.x, skinTemplate.boundingRectSize.y};
 
+      glm::vec2 vertTopLeft =  verticalStartPoint + glm::vec2{ i * sliceSize.x, 0.0};
+      glm::vec2 vertBottomRight = verticalStartPoint + glm::vec2{ (i + 1) * sliceSize.x, sliceSize.y};
+      updateRectangle(skinTemplate.verticalSlices[i], vertTopLeft, vertBottomRight);
+    }
+    for (auto i = 0; i < skinTemplate.leftHorSliceCount; i++)
+    {
+      float sliceWidth = skinTemplate.leftHorSliceWidthSpan * skinTemplate.boundingRectSize.x;
+      float sliceHeight = skinTemplate.leftHorSliceHeightSpan / skinTemplate.leftHorSliceCount * skinTemplate.boundingRectSize.y;
 
-      if(skinTemplate.drawSpline)
-      {
-        // generate the slices
-        auto boundingRectSize = skinTemplate.boundingRectSize;
-        std::vector<glm::vec2> splinePoints = {
-          glm::vec2{0, boundingRectSize.y / 2} + glm::vec2(transform.translation),
-          glm::vec2{boundingRectSize.x / 2, 0} + glm::vec2(transform.translation),
-          glm::vec2{boundingRectSize.x, boundingRectSize.y} + glm::vec2{0, -boundingRectSize.y / 2} + glm::vec2(transform.translation),
-          glm::vec2{boundingRectSize.x, boundingRectSize.y} + glm::vec2{-boundingRectSize.x / 2, 0} + glm::vec2(transform.translation)
-        };
-
-        auto createSpline = [](glm::vec2 begin, glm::vec2 middle, glm::vec2 end, glm::vec4 color, DrawObjectType type) -> Entity
-        {
-          auto spline = SplineComponentWrapper::CreateSpline(begin, middle, end, type);
-          spline.GetComponent<ColorComponent>().color = {0.0, 0.0, 0.0, 1.0}; 
-          spline.GetComponent<CommonAttributesComponent>().composed = true;
-          return spline;
-        };
-        skinTemplate.splines.push_back(createSpline(splinePoints[0], splinePoints[1], splinePoints[2], color.color, objectType));
-        skinTemplate.splines.push_back(createSpline(splinePoints[0], splinePoints[3], splinePoints[2], color.color, objectType));
-      }
+      glm::vec2 horTopLeft = leftHorStartPoint + glm::vec2{0.0, i * sliceHeight};
+      glm::vec2 horBottomRight = leftHorStartPoint + glm::vec2{sliceWidth, (i + 1) * sliceHeight};
+      updateRectangle(skinTemplate.leftHorizontalSlices[i], horTopLeft, horBottomRight);
+    }
+
+    for (auto i = 0; i < skinTemplate.rightHorSliceCount; i++)
+    {
+      float sliceWidth = skinTemplate.rightHorSliceWidthSpan * skinTemplate.boundingRectSize.x;
+      float sliceHeight = skinTemplate.rightHorSliceHeightSpan / skinTemplate.rightHorSliceCount * skinTemplate.boundingRectSize.y;
+
+      glm::vec2 horTopLeft = rightHorStartPoint + glm::vec2{0.0, i * sliceHeight};
+      glm::vec2 horBottomRight = rightHorStartPoint + glm::vec2{sliceWidth, (i + 1) * sliceHeight};
+      updateRectangle(skinTemplate.rightHorizontalSlices[i], horTopLeft, horBottomRight);
+    }
+
+    if(skinTemplate.drawSpline)
+    {
+      auto boundingRectSize = skinTemplate.boundingRectSize;
+      const std::array<glm::vec2, 4> splinePoints = {
+        glm::vec2{0, boundingRectSize.y / 2} + glm::vec2(transform.translation),
+        glm::vec2{boundingRectSize.x / 2, 0} + glm::vec2(transform.translation),
+        glm::vec2{boundingRectSize.x, boundingRectSize.y} + glm::vec2{0, -boundingRectSize.y / 2} + glm::vec2(transform.translation),
+        glm::vec2{boundingRectSize.x, boundingRectSize.y} + glm::vec2{-boundingRectSize.x / 2, 0} + glm::vec2(transform.translation)
+      };
+      SplineComponentWrapper(entity.FromHandle(skinTemplate.splines[0])).SetPoints(splinePoints[0], splinePoints[1], splinePoints[2]);
+      SplineComponentWrapper(entity.FromHandle(skinTemplate.splines[1])).SetPoints(splinePoints[0], splinePoints[3], splinePoints[2]);
     }
   }
 
@@ -648,16 +833,12 @@ namespace medicimage
   void SkinTemplateComponentWrapper::UpdateShapeAttributes()
   {
     auto& skinTemplate = m_entity.GetComponent<SkinTemplateComponent>();
-    if(!m_entity.HasComponent<BoundingContourComponent>())
-      m_entity.AddComponent<BoundingContourComponent>();
     if(!m_entity.HasComponent<PickPointsComponent>())
       m_entity.AddComponent<PickPointsComponent>();
 
-    auto& boundingBox = m_entity.GetComponent<BoundingContourComponent>();
     auto& pickPoints = m_entity.GetComponent<PickPointsComponent>();
     
     auto boundingRectSize = skinTemplate.boundingRectSize;
-    boundingBox.cornerPoints = {{0,0}, {boundingRectSize.x, 0}, {boundingRectSize.x, boundingRectSize.y}, {0, boundingRectSize.y}, {0,0}};
     auto  leftHorizontalTop = glm::vec2{skinTemplate.leftHorSliceWidthSpan * skinTemplate.boundingRectSize.x / 2, 
       (1 - skinTemplate.leftHorSliceHeightSpan) / 2 * skinTemplate.boundingRectSize.y};
     auto verticalLeft = glm::vec2{ skinTemplate.leftHorSliceWidthSpan * skinTemplate.boundingRectSize.x, skinTemplate.boundingRectSize.y / 2.0 };
@@ -676,6 +857,7 @@ namespace medicimage
       rightHorizontalTop,                                                                                         // RIGHT_SLICES_TOP 
       rightHorizontalTop + glm::vec2{0.0, skinTemplate.rightHorSliceHeightSpan * skinTemplate.boundingRectSize.y} // RIGHT_SLICES_BOTTOM  
       };
+    SetBoundingContour({{0,0}, {boundingRectSize.x, 0}, {boundingRectSize.x, boundingRectSize.y}, {0, boundingRectSize.y}, {0,0}});
 
     GenerateSlices(m_entity);
   }
@@ -715,7 +897,7 @@ namespace medicimage
         auto& skinTemplate = m_entity.GetComponent<SkinTemplateComponent>();
         float xScale = (-diff.x) / skinTemplate.boundingRectSize.x;
         skinTemplate.boundingRectSize.x += -diff.x;
-        m_entity.GetComponent<TransformComponent>().translation += glm::vec2{diff.x, 0};
+        Translate(glm::vec2{diff.x, 0});
         GenerateSlices(m_entity);
         break;
       }
@@ -724,7 +906,7 @@ namespace medicimage
         auto& skinTemplate = m_entity.GetComponent<SkinTemplateComponent>();
         float yScale = (-diff.y) / skinTemplate.boundingRectSize.y;
         skinTemplate.boundingRectSize.y += -diff.y;
-        m_entity.GetComponent<TransformComponent>().translation += glm::vec2{0, diff.y};
+        Translate(glm::vec2{0, diff.y});
         GenerateSlices(m_entity);
         break;
       }
@@ -794,8 +976,7 @@ namespace medicimage
   void SkinTemplateComponentWrapper::OnObjectDrag(glm::vec2 diff)
   {
     // TODO: some checks wether we drag the component outside or not etc..
-    auto& transform = m_entity.GetComponent<TransformComponent>();
-    transform.translation += diff;
+    Translate(diff);
     UpdateShapeAttributes();
   }
 
@@ -804,37 +985,36 @@ namespace medicimage
     auto& skinTemplate = m_entity.GetComponent<SkinTemplateComponent>();
     for(auto e : skinTemplate.verticalSlices)
     { // TODO REFACTOR: make it a lambda
-      Entity rect(e);
+      Entity rect = m_entity.FromHandle(e);
       RectangleComponentWrapper rw(rect);
       rw.Draw();
     }
     for(auto e : skinTemplate.leftHorizontalSlices)
     {
-      Entity rect(e);
+      Entity rect = m_entity.FromHandle(e);
       RectangleComponentWrapper rw(rect);
       rw.Draw();
     }
     for(auto e : skinTemplate.rightHorizontalSlices)
     {
-      Entity rect(e);
+      Entity rect = m_entity.FromHandle(e);
       RectangleComponentWrapper rw(rect);
       rw.Draw();
     }
     for(auto e : skinTemplate.rightHorizontalSlices)
     {
-      Entity rect(e);
+      Entity rect = m_entity.FromHandle(e);
       RectangleComponentWrapper rw(rect);
       rw.Draw();
     }
     for(auto e : skinTemplate.splines)
     {
-      Entity entity(e);
+      Entity entity = m_entity.FromHandle(e);
       SplineComponentWrapper sw(entity);
       sw.Draw();
     }
 
-    auto commonAttributes = m_entity.GetComponent<CommonAttributesComponent>();
-    if(commonAttributes.selected)
+    if(m_entity.HasComponent<SelectedTag>())
     {
       auto& pickPoints = m_entity.GetComponent<PickPointsComponent>().pickPoints;
       auto& translation = m_entity.GetComponent<TransformComponent>().translation;
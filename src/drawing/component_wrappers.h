@@ -17,6 +17,11 @@ public:
   bool IsComposed(){return m_entity.GetComponent<CommonAttributesComponent>().composed;}
   Entity GetEntity(){return m_entity;}
 protected:
+  // the transform and the bounding contour are changed through these, so the sheet's spatial index gets notified,
+  // the contour has to be set after the pickpoints, because the indexed box covers both
+  void SetBoundingContour(std::initializer_list<glm::vec2> points);
+  void Translate(glm::vec2 diff);
+
   Entity m_entity;
   static constexpr glm::vec4 s_selectBoxColor{0.23, 0.55, 0.70, 0.5};
   static constexpr glm::vec4 s_pickPointColor{0.14, 0.50, 0.62, 0.5};
@@ -30,7 +35,9 @@ public:
   /// @brief Factory function for creating an entity describing a rectangle 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing a rectangle, TODO: should we return with RectangleComponentWrapper 
-  static Entity CreateRectangle(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  static Entity CreateRectangle(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  // moves/resizes the rectangle in place to the box spanned by the two points
+  void SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint);
   void UpdateShapeAttributes() override;
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override;
   void OnObjectDrag(glm::vec2 diff) override;
@@ -44,7 +51,9 @@ public:
   /// @brief Factory function for creating an entity describing a circle 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing a circle, TODO: should we return with CircleComponentWrapper 
-  static Entity CreateCircle(glm::vec2 firstPoint, glm::vec2 secondPoint, float aspectRatio, DrawObjectType objectType);
+  static Entity CreateCircle(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, float aspectRatio, DrawObjectType objectType);
+  // the setters update the shape in place, e.g. the preview while it is being drawn
+  void SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint, float aspectRatio);
   void UpdateShapeAttributes() override;
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override;
   void OnObjectDrag(glm::vec2 diff) override;
@@ -58,7 +67,8 @@ public:
   /// @brief Factory function for creating an entity describing an arrow 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing an arrow, TODO: should we return with ArrowComponentWrapper 
-  static Entity CreateArrow(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  static Entity CreateArrow(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  void SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint);
   void UpdateShapeAttributes() override;
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override;
   void OnObjectDrag(glm::vec2 diff) override;
@@ -72,13 +82,41 @@ public:
   /// @brief Factory function for creating an entity describing an arrow 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing an arrow, TODO: should we return with LineComponentWrapper 
-  static Entity CreateLine(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  static Entity CreateLine(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  void SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint);
   void UpdateShapeAttributes() override;
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override;
   void OnObjectDrag(glm::vec2 diff) override;
   void Draw() override;
 };
 
+/// @brief Component wrapper for the outlines drawn with the multiline tool, all of their segments are in one entity
+class PolylineComponentWrapper : public BaseDrawComponentWrapper
+{
+public:
+  PolylineComponentWrapper(Entity entity) : BaseDrawComponentWrapper(entity) {}
+  /// @brief Factory function for creating an entity describing a polyline 
+  /// @param points absolute positions of the vertices, the first one becomes the translation
+  /// @return Entity containing the components needed for describing a polyline
+  static Entity CreatePolyline(entt::registry& registry, std::span<const glm::vec2> points, DrawObjectType objectType);
+  // appends an absolute position to the end of the outline, the pickpoints and the contour are updated in constant time
+  void AddPoint(glm::vec2 point);
+  // Douglas-Peucker, drops the vertices closer to the simplified outline than the tolerance
+  void Simplify(float tolerance);
+  void UpdateShapeAttributes() override;
+  void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override;
+  void OnObjectDrag(glm::vec2 diff) override;
+  void Draw() override;
+  // draws only the segments from the given vertex on, used for extending an already rasterized stroke
+  void DrawFrom(size_t firstPoint);
+private:
+  void SetBounds(glm::vec2 min, glm::vec2 max);
+  size_t GetPickedVertex(int selectedPoint);
+  // every vertex is a pickpoint of the outlines, the freehand strokes with more vertices can be reshaped at their ends only
+  static constexpr size_t s_maxVertexPickPoints = 64;
+  static constexpr glm::vec2 s_contourOffset{0.01f, 0.01f};
+};
+
 class TextComponentWrapper : public BaseDrawComponentWrapper
 {
 public:
@@ -86,11 +124,13 @@ public:
   /// @brief Factory function for creating an entity describing an arrow 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing an arrow, TODO: should we return with TextComponentWrapper 
-  static Entity CreateText(glm::vec2 firstPoint, const std::string& inputText,int fontSize, DrawObjectType objectType);
+  static Entity CreateText(entt::registry& registry, glm::vec2 firstPoint, const std::string& inputText,int fontSize, DrawObjectType objectType);
   void UpdateShapeAttributes() override;
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override {}
   void OnObjectDrag(glm::vec2 diff) override;
   void Draw() override;
+private:
+  const TextLayout& GetLayout();
 };
 
 /// @brief Component wrapper for Spline, it is special because it can be drawn from other components
@@ -102,7 +142,8 @@ public:
   /// @brief Factory function for creating an entity describing an arrow 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing an arrow, TODO: should we return with TextComponentWrapper 
-  static Entity CreateSpline(glm::vec2 begin, glm::vec2 middle, glm::vec2 end, DrawObjectType objectType);
+  static Entity CreateSpline(entt::registry& registry, glm::vec2 begin, glm::vec2 middle, glm::vec2 end, DrawObjectType objectType);
+  void SetPoints(glm::vec2 begin, glm::vec2 middle, glm::vec2 end);
   void UpdateShapeAttributes() override {};
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override {}
   void OnObjectDrag(glm::vec2 diff) override {};
@@ -116,7 +157,8 @@ public:
   /// @brief Factory function for creating an entity describing an skin template 
   /// @param baseEntity base entity to which we add all the other components 
   /// @return Entity containing the components needed for describing an skin temaplte, TODO: should we return with SkinTemplateComponentWrapper 
-  static Entity CreateSkinTemplate(glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  static Entity CreateSkinTemplate(entt::registry& registry, glm::vec2 firstPoint, glm::vec2 secondPoint, DrawObjectType objectType);
+  void SetPoints(glm::vec2 firstPoint, glm::vec2 secondPoint);
   void UpdateShapeAttributes() override;
   void OnPickPointDrag(glm::vec2 diff, int selectedPoint) override;
   void OnObjectDrag(glm::vec2 diff) override;
@@ -125,6 +167,8 @@ public:
   void SetLeftHorizontalWidthSpan(float span);
   void SetRightHorizontalWidthSpan(float span);
   void SetVertcialWidthSpan(float span);
+  // the slices are separate entities, they have to be destroyed together with the template
+  void DestroySlices();
 
   glm::ivec2 GetVerticalSliceCountBounds();
   glm::ivec2 GetLeftHorizontalSliceCountBounds();
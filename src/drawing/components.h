@@ -1,6 +1,11 @@
 #pragma once
 
 
+#include <array>
+#include <cassert>
+#include <initializer_list>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,6 +14,8 @@
 
 namespace medicimage
 {
+  struct TextLayout;
+
 	struct IDComponent
 	{
 		int ID;
@@ -45,16 +52,34 @@ namespace medicimage
 
   struct BoundingContourComponent
   {
-    std::vector<glm::vec2> cornerPoints;  // storing the contour of the bounding contour
+    // the contours are at most a closed quad or a quad and the center, so they are stored inline
+    static constexpr int s_maxPoints = 5;
+    std::array<glm::vec2, s_maxPoints> cornerPoints{};
+    int pointCount = 0;
+    glm::vec2 min{0.0f, 0.0f};  // axis aligned bounds of the contour, relative to the translation
+    glm::vec2 max{0.0f, 0.0f};
     BoundingContourComponent() = default;
     BoundingContourComponent(const BoundingContourComponent&) = default;
-    BoundingContourComponent(const std::vector<glm::vec2>& points) : cornerPoints(points) {}
+    BoundingContourComponent(std::initializer_list<glm::vec2> points) { SetPoints(points); }
+
+    void SetPoints(std::initializer_list<glm::vec2> points)
+    {
+      assert(points.size() <= s_maxPoints);
+      pointCount = 0;
+      min = max = points.size() != 0 ? *points.begin() : glm::vec2{0.0f, 0.0f};
+      for(const auto& point : points)
+      {
+        cornerPoints[pointCount++] = point;
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+      }
+    }
+    std::span<const glm::vec2> GetPoints() const { return {cornerPoints.data(), static_cast<size_t>(pointCount)}; }
   };
 
   struct PickPointsComponent
   {
     std::vector<glm::vec2> pickPoints;
-    int selectedPoint = -1;
     PickPointsComponent() = default;
     PickPointsComponent(const PickPointsComponent&) = default;
     PickPointsComponent(const std::vector<glm::vec2>& points) : pickPoints(points) {}
@@ -83,12 +108,18 @@ namespace medicimage
 
   struct CommonAttributesComponent
   {
-    bool selected = false;
     bool temporary = true;
     bool filled = false;
     bool composed = false;
     CommonAttributesComponent() = default;
-    CommonAttributesComponent(bool selected, bool temporary) : selected(selected), temporary(temporary){} 
+  };
+
+  // the selection is stored in its own storages, so the selected entities are iterated without visiting the others,
+  // it is not part of the saved annotations and the undo history
+  struct SelectedTag {};
+  struct SelectedPickPointComponent
+  {
+    int index = -1;
   };
 
   struct CircleComponent
@@ -133,6 +164,13 @@ namespace medicimage
       : end(end), begin(begin) {}
   };
 
+  struct PolylineComponent
+  {
+    // the vertices relative to the translation, stored contiguously so the outline is drawn and hit tested in one pass
+    std::vector<glm::vec2> points;
+    PolylineComponent() = default;
+  };
+
   struct SplineComponent
   {
      glm::vec2 begin{0.0f, 0.0f};
@@ -166,6 +204,7 @@ namespace medicimage
     std::string text = "";
     int fontSize = 1;
     glm::vec2 boxSize{0.0, 0.0};
+    std::shared_ptr<const TextLayout> layout; // cached by the drawing, it is not saved
     TextComponent() = default;
   };
 } // namespace medicimage
@@ -0,0 +1,178 @@
+#include "drawing/draw_list.h"
+#include "drawing/components.h"
+
+#include <algorithm>
+
+namespace medicimage
+{
+
+DrawList::~DrawList()
+{
+  Disconnect();
+}
+
+template<typename Component, DrawShape Shape>
+void DrawList::ConnectShape(entt::registry& registry)
+{
+  registry.on_construct<Component>().template connect<&DrawList::OnShapeConstructed<Shape>>(this);
+  registry.on_destroy<Component>().template connect<&DrawList::OnShapeDestroyed>(this);
+}
+
+template<typename Component>
+void DrawList::DisconnectShape(entt::registry& registry)
+{
+  registry.on_construct<Component>().disconnect(this);
+  registry.on_destroy<Component>().disconnect(this);
+}
+
+void DrawList::Connect(entt::registry& registry)
+{
+  Disconnect();
+  m_registry = &registry;
+  ConnectShape<CircleComponent, DrawShape::CIRCLE>(registry);
+  ConnectShape<RectangleComponent, DrawShape::RECTANGLE>(registry);
+  ConnectShape<ArrowComponent, DrawShape::ARROW>(registry);
+  ConnectShape<LineComponent, DrawShape::LINE>(registry);
+  ConnectShape<TextComponent, DrawShape::TEXT>(registry);
+  ConnectShape<SkinTemplateComponent, DrawShape::SKIN_TEMPLATE>(registry);
+  ConnectShape<SplineComponent, DrawShape::SPLINE>(registry);
+  ConnectShape<PolylineComponent, DrawShape::POLYLINE>(registry);
+}
+
+void DrawList::Disconnect()
+{
+  if(m_registry == nullptr)
+    return;
+  DisconnectShape<CircleComponent>(*m_registry);
+  DisconnectShape<RectangleComponent>(*m_registry);
+  DisconnectShape<ArrowComponent>(*m_registry);
+  DisconnectShape<LineComponent>(*m_registry);
+  DisconnectShape<TextComponent>(*m_registry);
+  DisconnectShape<SkinTemplateComponent>(*m_registry);
+  DisconnectShape<SplineComponent>(*m_registry);
+  DisconnectShape<PolylineComponent>(*m_registry);
+  m_registry = nullptr;
+  m_items.clear();
+  m_slots.clear();
+  m_temporaries.clear();
+  m_removedCount = 0;
+}
+
+template<DrawShape Shape>
+void DrawList::OnShapeConstructed(entt::registry& registry, entt::entity entity)
+{
+  // the factories set the temporary flag before adding the shape component
+  Append(Item{entity, Shape});
+  if(registry.get<CommonAttributesComponent>(entity).temporary)
+    m_temporaries.push_back(entity);
+}
+
+void DrawList::OnShapeDestroyed(entt::registry& registry, entt::entity entity)
+{
+  Erase(entity);
+}
+
+void DrawList::Append(Item item)
+{
+  m_slots[item.entity] = m_items.size();
+  m_items.push_back(item);
+}
+
+void DrawList::Erase(entt::entity entity)
+{
+  auto it = m_slots.find(entity);
+  if(it == m_slots.end())
+    return;
+  m_items[it->second].entity = entt::null;
+  m_slots.erase(it);
+  m_removedCount++;
+  if(m_removedCount >= s_minCompactionSize && m_removedCount * 2 >= m_items.size())
+    Compact();
+}
+
+void DrawList::Compact()
+{
+  std::erase_if(m_items, [](const Item& item) { return item.entity == entt::null; });
+  for(size_t i = 0; i < m_items.size(); i++)
+    m_slots[m_items[i].entity] = i;
+  m_removedCount = 0;
+}
+
+void DrawList::BringToFront(entt::entity entity)
+{
+  auto it = m_slots.find(entity);
+  if(it == m_slots.end())
+    return;
+  const Item item = m_items[it->second];
+  Erase(entity);
+  Append(item);
+}
+
+void DrawList::SendToBack(entt::entity entity)
+{
+  auto it = m_slots.find(entity);
+  if(it == m_slots.end())
+    return;
+  const Item item = m_items[it->second];
+  m_items.erase(m_items.begin() + it->second);
+  m_items.insert(m_items.begin(), item);
+  for(size_t i = 0; i < m_items.size(); i++)
+  {
+    if(m_items[i].entity != entt::null)
+      m_slots[m_items[i].entity] = i;
+  }
+}
+
+void DrawList::GetOrder(std::vector<entt::entity>& order) const
+{
+  order.clear();
+  ForEach([&order](const Item& item) { order.push_back(item.entity); });
+}
+
+size_t DrawList::GetOrder(entt::entity entity) const
+{
+  // the removed items are only nulled out, so the slots keep the relative order
+  auto it = m_slots.find(entity);
+  return it != m_slots.end() ? it->second + 1 : 0;
+}
+
+void DrawList::Place(std::span<const Placement> placements)
+{
+  // every placed item is taken out first, so inserting them from the lowest position does not shift the others
+  std::vector<Item> placed;
+  placed.reserve(placements.size());
+  for(const auto& placement : placements)
+  {
+    auto it = m_slots.find(placement.entity);
+    placed.push_back(it != m_slots.end() ? m_items[it->second] : Item{entt::null, DrawShape::CIRCLE});
+    if(it != m_slots.end())
+      m_items[it->second].entity = entt::null;
+  }
+  std::erase_if(m_items, [](const Item& item) { return item.entity == entt::null; });
+  for(size_t i = 0; i < placements.size(); i++)
+  {
+    if(placed[i].entity != entt::null)
+      m_items.insert(m_items.begin() + std::min(placements[i].position, m_items.size()), placed[i]);
+  }
+  for(size_t i = 0; i < m_items.size(); i++)
+    m_slots[m_items[i].entity] = i;
+  m_removedCount = 0;
+}
+
+void DrawList::DestroyTemporaries()
+{
+  // destroying can trigger the destruction of other temporaries through the signals, so the list is taken over first
+  std::vector<entt::entity> temporaries;
+  std::swap(temporaries, m_temporaries);
+  for(auto e : temporaries)
+  {
+    if(m_registry->valid(e))
+      m_registry->destroy(e);
+  }
+  temporaries.clear();
+  // keep the capacity, there are temporaries on almost every frame while drawing
+  if(m_temporaries.empty())
+    std::swap(temporaries, m_temporaries);
+}
+
+} // namespace medicimage
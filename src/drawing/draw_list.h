@@ -0,0 +1,83 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace medicimage
+{
+
+enum class DrawShape{CIRCLE, RECTANGLE, ARROW, LINE, TEXT, SKIN_TEMPLATE, SPLINE, POLYLINE};
+
+/// @brief Z-ordered list of the drawable entities of a registry, the first item is drawn first (at the bottom).
+///         It is kept up to date through the construct/destroy signals of the shape components, so the sheet
+///         does not have to walk a view per shape type, and the temporaries are collected in a separate list
+class DrawList
+{
+public:
+  struct Item
+  {
+    entt::entity entity;
+    DrawShape shape;
+  };
+  struct Placement
+  {
+    entt::entity entity;
+    size_t position; // counted from the bottom, without the removed items
+  };
+
+  DrawList() = default;
+  DrawList(const DrawList&) = delete;
+  DrawList& operator=(const DrawList&) = delete;
+  ~DrawList();
+
+  void Connect(entt::registry& registry);
+  void Disconnect();
+
+  // visits the items from the bottom to the top
+  template<typename Func>
+  void ForEach(Func&& func) const
+  {
+    for(const auto& item : m_items)
+    {
+      if(item.entity != entt::null)
+        func(item);
+    }
+  }
+
+  void BringToFront(entt::entity entity);
+  void SendToBack(entt::entity entity);
+  // the entities from the bottom to the top
+  void GetOrder(std::vector<entt::entity>& order) const;
+  // the higher one is drawn over the lower one, it is only for comparing entities; the ones not in the list are at the bottom
+  size_t GetOrder(entt::entity entity) const;
+  // puts the entities back to their positions, e.g. the ones restored by the undo, which were appended on top;
+  // the placements have to be ordered by their positions
+  void Place(std::span<const Placement> placements);
+  // the temporaries live until they are drawn once, this destroys them without scanning the whole list
+  void DestroyTemporaries();
+  size_t GetSize() const {return m_items.size() - m_removedCount;}
+private:
+  template<typename Component, DrawShape Shape>
+  void ConnectShape(entt::registry& registry);
+  template<typename Component>
+  void DisconnectShape(entt::registry& registry);
+  template<DrawShape Shape>
+  void OnShapeConstructed(entt::registry& registry, entt::entity entity);
+  void OnShapeDestroyed(entt::registry& registry, entt::entity entity);
+  void Append(Item item);
+  void Erase(entt::entity entity);
+  void Compact();
+
+  // removed items are only nulled out, the list is compacted when they make up the half of it
+  std::vector<Item> m_items;
+  std::unordered_map<entt::entity, size_t> m_slots;
+  size_t m_removedCount = 0;
+  std::vector<entt::entity> m_temporaries;
+  entt::registry* m_registry = nullptr;
+  static constexpr size_t s_minCompactionSize = 32;
+};
+
+} // namespace medicimage
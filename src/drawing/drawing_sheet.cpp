@@ -2,6 +2,8 @@
 #include "drawing/components.h"
 #include "drawing/drawing_sheet.h"
 #include "drawing/component_wrappers.h"
+#include "drawing/hit_testing.h"
+#include "drawing/registry_archive.h"
 #include "core/log.h"
 #include "image_handling/image_editor.h"
 #include <algorithm>
@@ -15,22 +17,100 @@ namespace medicimage
 {
   void DrawingSheet::SetDocument(std::unique_ptr<ImageDocument> doc, glm::vec2 viewportSize)
   {
-    // clear the registry for clear drawing
-    auto objects = Entity::View<TransformComponent>();
-    for(auto e : objects)
-    {
-      Entity entity(e);
-      Entity::DestroyEntity(entity);
-    }
+    // the sheet is reused for the next document, its annotations start from scratch
+    DiscardPreview();
+    m_polyline.reset();
+    m_stroke.reset();
+    m_strokeLayer.release();
+    m_registry.clear();
 
     m_sheetSize = viewportSize;
+    m_drawingValid = false;
     m_originalDoc = std::move(doc);
     m_drawing = std::make_unique<Texture2D>(m_originalDoc->texture->GetTexturePtr(), "texture");
+    // a saved annotated document is its clean frame and the entities, they are rebuilt instead of decoding the burnt in image
+    if(!m_originalDoc->annotations.empty())
+      LoadAnnotations(m_originalDoc->annotations);
+    m_history.Clear();
+  }
+
+  static constexpr std::uint32_t s_annotationsMagic = 0x4e41494d; // "MIAN"
+  static constexpr std::uint32_t s_annotationsVersion = 2; // 2: polylines
+
+  std::vector<char> DrawingSheet::SaveAnnotations()
+  {
+    // only the committed shapes are saved
+    EndStroke();
+    DiscardPreview();
+    m_drawList.DestroyTemporaries();
+
+    OutputArchive archive;
+    archive.Write(s_annotationsMagic);
+    archive.Write(s_annotationsVersion);
+    SaveSnapshot(m_registry, archive);
+    // the snapshot is in storage order, the z order is saved after it
+    std::vector<entt::entity> drawOrder;
+    drawOrder.reserve(m_drawList.GetSize());
+    m_drawList.ForEach([&drawOrder](const DrawList::Item& item) { drawOrder.push_back(item.entity); });
+    archive.Write(drawOrder);
+    return std::move(archive.GetBuffer());
+  }
+
+  static bool ReadAnnotations(entt::registry& registry, std::span<const char> data, std::vector<entt::entity>& drawOrder)
+  {
+    InputArchive archive(data);
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    archive.Read(magic);
+    archive.Read(version);
+    if(magic != s_annotationsMagic || version != s_annotationsVersion)
+    {
+      APP_CORE_ERR("Unsupported annotation data (version:{})", version);
+      return false;
+    }
+    if(!LoadSnapshot(registry, archive))
+      return false;
+    archive.Read(drawOrder);
+    if(archive.Failed())
+    { // a half loaded sheet is not shown
+      APP_CORE_ERR("Corrupted annotation data");
+      registry.clear();
+      return false;
+    }
+    return true;
+  }
+
+  bool DrawingSheet::CheckAnnotations(std::span<const char> data)
+  {
+    // loaded into a registry of its own, nothing is connected to it
+    entt::registry registry;
+    std::vector<entt::entity> drawOrder;
+    return ReadAnnotations(registry, data, drawOrder);
+  }
+
+  bool DrawingSheet::LoadAnnotations(std::span<const char> data)
+  {
+    std::vector<entt::entity> drawOrder;
+    if(!ReadAnnotations(m_registry, data, drawOrder))
+    {
+      APP_CORE_ERR("The document is opened without annotations");
+      return false;
+    }
+    for(auto e : drawOrder)
+    {
+      if(m_registry.valid(e))
+        m_drawList.BringToFront(e);
+    }
+    return true;
   }
   
   void DrawingSheet::SetDrawCommand(const DrawCommand command)
   {
+    EndStroke();
     m_currentDrawCommand = command;
+    // a new command starts a new outline
+    EndPolyline();
+    m_drawingValid = false;
 
     // set the initial command state according to the draw command
     switch(command)
@@ -43,22 +123,27 @@ namespace medicimage
       case DrawCommand::DRAW_MULTILINE:
       case DrawCommand::DRAW_SKIN_TEMPLATE:
       {
-        m_drawState = std::make_unique<InitialObjectDrawState>(this);
+        EmplaceDrawState<InitialObjectDrawState>();
         break;
       }
       case DrawCommand::DRAW_TEXT:
       {
-        m_drawState = std::make_unique<DrawTextInitialState>(this);
+        EmplaceDrawState<DrawTextInitialState>();
         break;
       }
       case DrawCommand::DRAW_INCREMENTAL_LETTERS:
       {
-        m_drawState = std::make_unique<DrawIncrementalLetters>(this);
+        EmplaceDrawState<DrawIncrementalLetters>();
+        break;
+      }
+      case DrawCommand::DRAW_FREEHAND:
+      {
+        EmplaceDrawState<DrawFreehandState>();
         break;
       }
       case DrawCommand::DO_NOTHING:
       {
-        m_drawState = std::make_unique<BaseDrawState>(this);
+        EmplaceDrawState<BaseDrawState>();
         break;
       }
     }
@@ -77,6 +162,7 @@ namespace medicimage
       case DrawCommand::DRAW_TEXT: return "DRAW_TEXT";
       case DrawCommand::DRAW_INCREMENTAL_LETTERS: return "DRAW_INCREMENTAL_LETTERS";
       case DrawCommand::DRAW_SKIN_TEMPLATE: return "DRAW_SKIN_TEMPLATE";
+      case DrawCommand::DRAW_FREEHAND: return "DRAW_FREEHAND";
       case DrawCommand::DO_NOTHING: return "DO_NOTHING";
       default: return "UNKNOWN";
     }
@@ -84,91 +170,145 @@ namespace medicimage
 
   std::unique_ptr<Texture2D> DrawingSheet::Draw()
   {
+    if(m_stroke.has_value() && !m_strokeLayer.empty())
+    {
+      // while a stroke is drawn nothing else changes, so only its new segments are rasterized onto the layer
+      PolylineComponentWrapper stroke(m_stroke.value());
+      ImageEditor::Begin(m_strokeLayer);
+      stroke.DrawFrom(m_strokeRasterized);
+      ImageEditor::End(m_strokeLayer, m_drawing.get());
+      m_strokeRasterized = m_stroke->GetComponent<PolylineComponent>().points.size();
+      return std::make_unique<Texture2D>(*m_drawing.get());
+    }
+    if(m_drawingValid && std::visit([](auto& state){ return state.IsOverlay(); }, m_drawState))
+      return std::make_unique<Texture2D>(*m_drawing.get());
+
     std::stringstream ss;
     ss << std::put_time(std::localtime(&(m_originalDoc->timestamp)), "%d-%b-%Y %X");
     std::string footerText = m_originalDoc->documentId + " - " + ss.str();
     m_drawing = ImageEditor::AddImageFooter(footerText, m_originalDoc->texture.get());
 
     ImageEditor::Begin(m_drawing.get());
-    auto circles = Entity::View<CircleComponent>();
-    for(auto e : circles)
+    DrawEntities();
+    if(m_stroke.has_value())
     {
-      Entity entity(e);
-      CircleComponentWrapper cw(entity);
-      if(!cw.IsComposed())
-        cw.Draw();
+      // the first frame of a stroke keeps the rasterized sheet for the following ones
+      ImageEditor::End(m_strokeLayer, m_drawing.get());
+      m_strokeRasterized = m_stroke->GetComponent<PolylineComponent>().points.size();
     }
+    else
+      ImageEditor::End(m_drawing.get());
 
-    auto rectangles = Entity::View<RectangleComponent>();
-    for(auto e : rectangles)
-    {
-      Entity entity(e);
-      RectangleComponentWrapper rw(entity);
-      if(!rw.IsComposed())
-        rw.Draw(); 
-    }
-    
-    auto arrows = Entity::View<ArrowComponent>();
-    for(auto e : arrows)
-    {
-      Entity entity(e);
-      ArrowComponentWrapper aw(entity);
-      if(!aw.IsComposed())
-        aw.Draw();
-    }
-    
-    auto lines = Entity::View<LineComponent>();
-    for(auto e : lines)
-    {
-      Entity entity(e);
-      LineComponentWrapper lw(entity);
-      if(!lw.IsComposed())
-        lw.Draw();
-    }
-    
-    auto texts = Entity::View<TextComponent>();
-    for(auto e : texts)
-    {
-      Entity entity(e);
-      TextComponentWrapper tw(entity);
-      if(!tw.IsComposed())
-        tw.Draw();
-    }
+    m_drawList.DestroyTemporaries();
+    m_drawingValid = true;
 
-    auto skinTemplates = Entity::View<SkinTemplateComponent>();
-    for(auto e : skinTemplates)
-    {
-      Entity entity(e);
-      SkinTemplateComponentWrapper sw(entity);
-      if(!sw.IsComposed())
-        sw.Draw();
-    }
-    
-    auto splines = Entity::View<SplineComponent>();
-    for(auto e : splines)
-    {
-      Entity entity(e);
-      SplineComponentWrapper sw(entity);
-      if(!sw.IsComposed())
-        sw.Draw();
-    }
+    return std::move(std::make_unique<Texture2D>(*m_drawing.get()));
+  }
+
+  template<typename Wrapper>
+  static void DrawEntity(Entity entity)
+  {
+    Wrapper wrapper(entity);
+    if(!wrapper.IsComposed())
+      wrapper.Draw();
+  }
+
+  void DrawingSheet::DrawEntities()
+  {
+    // one pass in z order, the wrapper type is picked by the shape stored in the list
+    m_drawList.ForEach([this](const DrawList::Item& item) {
+      Entity entity(item.entity, &m_registry);
+      switch(item.shape)
+      {
+        case DrawShape::CIRCLE: DrawEntity<CircleComponentWrapper>(entity); break;
+        case DrawShape::RECTANGLE: DrawEntity<RectangleComponentWrapper>(entity); break;
+        case DrawShape::ARROW: DrawEntity<ArrowComponentWrapper>(entity); break;
+        case DrawShape::LINE: DrawEntity<LineComponentWrapper>(entity); break;
+        case DrawShape::TEXT: DrawEntity<TextComponentWrapper>(entity); break;
+        case DrawShape::SKIN_TEMPLATE: DrawEntity<SkinTemplateComponentWrapper>(entity); break;
+        case DrawShape::SPLINE: DrawEntity<SplineComponentWrapper>(entity); break;
+        case DrawShape::POLYLINE: DrawEntity<PolylineComponentWrapper>(entity); break;
+      }
+    });
+  }
 
-    ImageEditor::End(m_drawing.get());
+  void DrawingSheet::BringToFront(Entity entity)
+  {
+    // the z order is part of the history, the step holds only the position of the entity
+    m_history.Begin();
+    m_history.Track(entity);
+    m_drawList.BringToFront(entity.GetHandle());
+    m_history.Commit();
+  }
 
-    std::for_each(circles.begin(), circles.end(), m_drawState->DeleteTemporaries());
-    std::for_each(rectangles.begin(), rectangles.end(), m_drawState->DeleteTemporaries());
-    std::for_each(arrows.begin(), arrows.end(), m_drawState->DeleteTemporaries());
-    std::for_each(lines.begin(), lines.end(), m_drawState->DeleteTemporaries());
-    std::for_each(texts.begin(), texts.end(), m_drawState->DeleteTemporaries());
-    std::for_each(skinTemplates.begin(), skinTemplates.end(), m_drawState->DeleteTemporaries());
-    std::for_each(splines.begin(), splines.end(), m_drawState->DeleteTemporaries());
+  void DrawingSheet::SendToBack(Entity entity)
+  {
+    m_history.Begin();
+    m_history.Track(entity);
+    m_drawList.SendToBack(entity.GetHandle());
+    m_history.Commit();
+  }
 
-    return std::move(std::make_unique<Texture2D>(*m_drawing.get()));
+  bool DrawingSheet::Undo()
+  {
+    // the shape being drawn and the temporaries are not part of the history, an unfinished stroke is finished first
+    EndStroke();
+    DiscardPreview();
+    m_drawList.DestroyTemporaries();
+    if(!m_history.Undo())
+      return false;
+    OnHistoryRestored();
+    return true;
+  }
+
+  bool DrawingSheet::Redo()
+  {
+    EndStroke();
+    DiscardPreview();
+    m_drawList.DestroyTemporaries();
+    if(!m_history.Redo())
+      return false;
+    OnHistoryRestored();
+    return true;
+  }
+
+  void DrawingSheet::OnHistoryRestored()
+  {
+    // the selection may refer to entities which are gone, so it starts over
+    ClearSelectionShapes();
+    m_hoveredEntity.reset();
+    m_polyline.reset();
+    m_drawingValid = false;
+    if(m_currentDrawCommand == DrawCommand::OBJECT_SELECT)
+      ChangeDrawState<ObjectSelectInitialState>();
   }
 
-  void DrawingSheet::ChangeDrawState(std::unique_ptr<BaseDrawState> newState)
+  void DrawingSheet::BeginModify(Entity entity)
   {
-    m_drawState = std::move(newState);
+    m_history.Begin();
+    m_history.Track(entity);
+  }
+
+  void DrawingSheet::CommitModify()
+  {
+    m_history.Commit();
+  }
+
+  void DrawingSheet::DeleteEntity(Entity entity)
+  {
+    m_history.Begin();
+    m_history.Track(entity);
+    if(entity.HasComponent<SkinTemplateComponent>())
+      SkinTemplateComponentWrapper(entity).DestroySlices();
+    Entity::DestroyEntity(entity);
+    m_history.Commit();
+  }
+
+  void DrawingSheet::RecordCreated(Entity entity)
+  {
+    m_history.Begin();
+    m_history.TrackCreated(entity);
+    m_history.Commit();
   }
 
   void DrawingSheet::SetDrawingSheetSize(glm::vec2 size)
@@ -179,63 +319,84 @@ namespace medicimage
   void DrawingSheet::OnMouseHovered(const glm::vec2 pos)
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnMouseHovered(pos);
+      std::visit([&](auto& state){ state.OnMouseHovered(pos); }, m_drawState);
+  }
+
+  void DrawingSheet::OnMouseMoved(const glm::vec2 pos)
+  {
+    if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
+      std::visit([&](auto& state){ state.OnMouseMoved(pos); }, m_drawState);
   }
 
   void DrawingSheet::OnMouseButtonPressed(const glm::vec2 pos)
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnMouseButtonPressed(pos);
+      std::visit([&](auto& state){ state.OnMouseButtonPressed(pos); }, m_drawState);
   }
 
   void DrawingSheet::OnMouseButtonDown(const glm::vec2 pos)
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnMouseButtonDown(pos);
+      std::visit([&](auto& state){ state.OnMouseButtonDown(pos); }, m_drawState);
   }
 
   void DrawingSheet::OnMouseButtonReleased(const glm::vec2 pos)
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnMouseButtonReleased(pos);
+      std::visit([&](auto& state){ state.OnMouseButtonReleased(pos); }, m_drawState);
   }
 
-  void DrawingSheet::OnTextInput(const std::string &inputText)
+  void DrawingSheet::OnTextInput(std::string_view inputText)
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnTextInput(inputText);
+      std::visit([&](auto& state){ state.OnTextInput(inputText); }, m_drawState);
   }
 
   void DrawingSheet::OnKeyPressed(KeyCode key)
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnKeyPressed(key);
+      std::visit([&](auto& state){ state.OnKeyPressed(key); }, m_drawState);
+  }
+
+  void DrawingSheet::OnFocusLost()
+  {
+    if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
+      std::visit([](auto& state){ state.OnFocusLost(); }, m_drawState);
   }
 
   void DrawingSheet::OnUpdate()
   {
     if(m_currentDrawCommand != DrawCommand::DO_NOTHING)
-      m_drawState->OnUpdate();
+      std::visit([](auto& state){ state.OnUpdate(); }, m_drawState);
+  }
+
+  std::optional<TextOverlay> DrawingSheet::GetTextOverlay()
+  {
+    return std::visit([](auto& state){ return state.GetTextOverlay(); }, m_drawState);
+  }
+
+  const char* DrawingSheet::GetDrawStateName() const
+  {
+    return std::visit([](auto& state){ return state.GetName(); }, m_drawState);
+  }
+
+  std::vector<entt::entity> DrawingSheet::QueryPointTopmostFirst(glm::vec2 pos, float margin) const
+  {
+    auto candidates = m_spatialIndex.QueryPoint(pos, margin);
+    std::sort(candidates.begin(), candidates.end(), [this](entt::entity a, entt::entity b) {
+      return m_drawList.GetOrder(a) > m_drawList.GetOrder(b);
+    });
+    return candidates;
   }
 
   std::optional<Entity> DrawingSheet::GetHoveredEntity(const glm::vec2 pos)
   {
     // TODO: may want to move this into editor ui, so here only relative coordinates are handled
     const glm::vec2 relPos = GetNormalizedPos(pos);
-    auto view = Entity::View<BoundingContourComponent>();
-    for(auto e : view)
+    for(auto e : QueryPointTopmostFirst(relPos))
     {
-      Entity entity(e);
-      auto boundingContour = entity.GetComponent<BoundingContourComponent>().cornerPoints;
-      if(boundingContour.size() == 0)
-        continue;
-
-      auto translation = entity.GetComponent<TransformComponent>().translation;
-      for(auto& c : boundingContour)
-        c += translation;
-      std::vector<cv::Point2f> contour;
-      std::transform(boundingContour.begin(), boundingContour.end(), std::back_inserter(contour), [](glm::vec2 vec) {return cv::Point2f{ vec.x, vec.y }; });
-      if(cv::pointPolygonTest(contour, cv::Point2f{relPos.x, relPos.y}, false)  >= 0)
+      Entity entity(e, &m_registry);
+      if(HitTesting::IsUnderPoint(entity, relPos))
       {
         APP_CORE_TRACE("Entity:{} is hovered", entity.GetComponent<IDComponent>().ID);
         return entity;
@@ -247,96 +408,45 @@ namespace medicimage
   std::vector<Entity> DrawingSheet::GetSelectedEntities()
   {
     std::vector<Entity> selectedEntities;
-    auto view = Entity::View<CommonAttributesComponent>();
-    for(auto e : view)
-    {
-      Entity entity(e);
-      if(entity.GetComponent<CommonAttributesComponent>().selected)
-        selectedEntities.push_back(entity);
-    }
+    for(auto e : m_registry.view<SelectedTag>())
+      selectedEntities.push_back(Entity(e, &m_registry));
     return selectedEntities;
   }
   bool DrawingSheet::IsUnderSelectArea(Entity entity, glm::vec2 pos)
   {
-    auto boundingContour = entity.GetComponent<BoundingContourComponent>().cornerPoints;
-    auto translation = entity.GetComponent<TransformComponent>().translation;
-    for(auto& c : boundingContour)
-      c += translation;
-    std::vector<cv::Point2f> entityContour;
-    std::transform(boundingContour.begin(), boundingContour.end(), std::back_inserter(entityContour), [](glm::vec2 vec) {return cv::Point2f{ vec.x, vec.y }; });
-      
-    auto dx = m_secondPoint.x - m_firstPoint.x;
-    auto dy = m_secondPoint.y - m_firstPoint.y;
-    std::vector<cv::Point2f> selectContour{cv::Point2f{m_firstPoint.x, m_firstPoint.y}, cv::Point2f{m_firstPoint.x + dx, m_firstPoint.y},
-      cv::Point2f{m_secondPoint.x, m_secondPoint.y}, cv::Point2f{m_secondPoint.x - dx, m_secondPoint.y}};
-      
-    std::vector<cv::Point2f> tmp;
-    if (cv::intersectConvexConvex(selectContour, entityContour, tmp, true) > 0.0)
+    if(HitTesting::IsInsideArea(entity, glm::min(m_firstPoint, m_secondPoint), glm::max(m_firstPoint, m_secondPoint)))
     {
-      if(cv::intersectConvexConvex(selectContour, entityContour, tmp, false) == 0.0)
-      {
-        APP_CORE_INFO("Entity:{} selected with bb: tl:{}:{}, tr:{}:{}, br:{}:{}, bl:{}:{}", entity.GetComponent<IDComponent>().ID,
-          boundingContour[0].x, boundingContour[0].y, boundingContour[1].x, boundingContour[1].y, boundingContour[2].x, boundingContour[2].y, boundingContour[3].x, boundingContour[3].y);
-        return true;
-      }
+      APP_CORE_INFO("Entity:{} selected", entity.GetComponent<IDComponent>().ID);
+      return true;
     }
     return false;
   }
 
   bool DrawingSheet::IsPickpointSelected(Entity entity, glm::vec2 pos)
   {
-    auto pickPoints = entity.GetComponent<PickPointsComponent>().pickPoints;
-    assert(pickPoints.size() != 0);
-    auto translation = entity.GetComponent<TransformComponent>().translation;
-    for(auto& p : pickPoints)
-      p += translation;
-    for(int i = 0; i < pickPoints.size(); i++)
-    {
-      auto point = pickPoints[i];
-      std::vector<cv::Point2f> contour {{point.x - s_pickPointBoxSize / 2, point.y - s_pickPointBoxSize / 2}, {point.x + s_pickPointBoxSize / 2, point.y - s_pickPointBoxSize / 2},
-        {point.x + s_pickPointBoxSize / 2, point.y + s_pickPointBoxSize / 2}, {point.x - s_pickPointBoxSize / 2, point.y + s_pickPointBoxSize / 2}};
-      if(cv::pointPolygonTest(contour, cv::Point2f{pos.x, pos.y}, false)  >= 0)
-      {
-        entity.GetComponent<PickPointsComponent>().selectedPoint = i;
-        return true;
-      }
-    }
-    return false;
+    assert(entity.GetComponent<PickPointsComponent>().pickPoints.size() != 0);
+    const int pickPoint = HitTesting::GetPickPointAt(entity, pos, s_pickPointBoxSize);
+    if(pickPoint == -1)
+      return false;
+    m_registry.emplace_or_replace<SelectedPickPointComponent>(entity, pickPoint);
+    return true;
   }
 
   bool DrawingSheet::IsDragAreaSelected(Entity entity, glm::vec2 pos)
   {
-    auto boundingContour = entity.GetComponent<BoundingContourComponent>().cornerPoints;
-    assert(boundingContour.size() != 0);
-    auto translation = entity.GetComponent<TransformComponent>().translation;
-    for(auto& c : boundingContour)
-      c += translation;
-    std::vector<cv::Point2f> contour;
-    std::transform(boundingContour.begin(), boundingContour.end(), std::back_inserter(contour), [](glm::vec2 vec) {return cv::Point2f{ vec.x, vec.y }; });
-    if(cv::pointPolygonTest(contour, cv::Point2f{pos.x, pos.y}, false)  >= 0)
-      return true;
-    else
-      return false;
+    assert(entity.GetComponent<BoundingContourComponent>().pointCount != 0);
+    return HitTesting::IsUnderPoint(entity, pos);
   }
   
-  void DrawingSheet::ClearSelectionShapes()
+  void DrawingSheet::Select(Entity entity)
   {
-    // clear the selection and selected pickpoint
-    auto attributes = Entity::View<CommonAttributesComponent>();
-    for(auto e : attributes)
-    {
-      Entity entity(e);
-      if(entity.GetComponent<CommonAttributesComponent>().selected)
-        entity.GetComponent<CommonAttributesComponent>().selected = false;
-    }
+    m_registry.emplace_or_replace<SelectedTag>(entity);
+  }
 
-    auto pickpoints = Entity::View<PickPointsComponent>();
-    for(auto e : pickpoints)
-    {
-      Entity entity(e);
-      entity.GetComponent<PickPointsComponent>().selectedPoint = -1;
-    }
-    
+  void DrawingSheet::ClearSelectionShapes()
+  {
+    // clear the selection and selected pickpoint, only the selected entities are touched
+    m_registry.clear<SelectedTag, SelectedPickPointComponent>();
     m_draggedEntity.reset();
   }
 
@@ -348,6 +458,11 @@ namespace medicimage
     return normalizedPos;
   }
 
+  InitialObjectDrawState::InitialObjectDrawState(DrawingSheet* sheet) : BaseDrawState(sheet, "InitialObjectDrawState")
+  {
+    m_sheet->ClearSelectionShapes();
+  }
+
   void InitialObjectDrawState::OnMouseHovered(const glm::vec2 pos)
   {
     m_sheet->m_hoveredEntity = m_sheet->GetHoveredEntity(pos);
@@ -355,84 +470,245 @@ namespace medicimage
 
   void InitialObjectDrawState::OnMouseButtonPressed(const glm::vec2 pos)
   {
-    m_sheet->ChangeDrawState(std::make_unique<FirstClickRecievedState>(m_sheet)); 
+    m_sheet->ChangeDrawState<FirstClickRecievedState>();
   }
 
   void FirstClickRecievedState::OnMouseButtonDown(const glm::vec2 pos)
   {
     m_sheet->m_firstPoint = m_sheet->GetNormalizedPos(pos);
-    m_sheet->ChangeDrawState(std::make_unique<DrawingTemporaryState>(m_sheet)); 
+    m_sheet->ChangeDrawState<DrawingTemporaryState>();
   }
 
   void FirstClickRecievedState::OnMouseButtonReleased(const glm::vec2 pos)
   {
     // fallback to initial state, because it was just an accidental single click
-    m_sheet->ChangeDrawState(std::make_unique<InitialObjectDrawState>(m_sheet));
+    m_sheet->ChangeDrawState<InitialObjectDrawState>();
   }
 
-  static std::unique_ptr<BaseDrawComponentWrapper> CreateComponentWrapper(DrawCommand command, glm::vec2 firstPoint, glm::vec2 secondPoint, glm::vec2 sheetSize, DrawObjectType objectType)
+  static Entity CreateShape(entt::registry& registry, DrawCommand command, glm::vec2 firstPoint, glm::vec2 secondPoint, glm::vec2 sheetSize)
   {
     switch(command)
     {
       case DrawCommand::DRAW_CIRCLE:
-      {
-        return std::make_unique<CircleComponentWrapper>(CircleComponentWrapper::CreateCircle(firstPoint, secondPoint, sheetSize.x / sheetSize.y, objectType));
-      }
+        return CircleComponentWrapper::CreateCircle(registry, firstPoint, secondPoint, sheetSize.x / sheetSize.y, DrawObjectType::PERMANENT);
       case DrawCommand::DRAW_RECTANGLE:
-      {
-        return std::make_unique<RectangleComponentWrapper>(RectangleComponentWrapper::CreateRectangle(firstPoint, secondPoint, objectType));
-      }
+        return RectangleComponentWrapper::CreateRectangle(registry, firstPoint, secondPoint, DrawObjectType::PERMANENT);
       case DrawCommand::DRAW_ARROW:
-      {
-        return std::make_unique<ArrowComponentWrapper>(ArrowComponentWrapper::CreateArrow(firstPoint, secondPoint, objectType));
-      }
+        return ArrowComponentWrapper::CreateArrow(registry, firstPoint, secondPoint, DrawObjectType::PERMANENT);
       case DrawCommand::DRAW_LINE:
       case DrawCommand::DRAW_MULTILINE:
-      {
-        return std::make_unique<LineComponentWrapper>(LineComponentWrapper::CreateLine(firstPoint, secondPoint, objectType));
-      }
+        return LineComponentWrapper::CreateLine(registry, firstPoint, secondPoint, DrawObjectType::PERMANENT);
       case DrawCommand::DRAW_SKIN_TEMPLATE:
+        return SkinTemplateComponentWrapper::CreateSkinTemplate(registry, firstPoint, secondPoint, DrawObjectType::PERMANENT);
+      default:
+        APP_CORE_ERR("Invalid draw command");
+        return Entity();
+    }
+  }
+
+  // updates the shape in place, the wrappers live on the stack, so the dragging does not allocate
+  static void UpdateShape(Entity entity, DrawCommand command, glm::vec2 firstPoint, glm::vec2 secondPoint, glm::vec2 sheetSize)
+  {
+    auto update = [](auto wrapper, auto... points) {
+      wrapper.SetPoints(points...);
+      wrapper.UpdateShapeAttributes();
+    };
+    switch(command)
+    {
+      case DrawCommand::DRAW_CIRCLE: update(CircleComponentWrapper(entity), firstPoint, secondPoint, sheetSize.x / sheetSize.y); break;
+      case DrawCommand::DRAW_RECTANGLE: update(RectangleComponentWrapper(entity), firstPoint, secondPoint); break;
+      case DrawCommand::DRAW_ARROW: update(ArrowComponentWrapper(entity), firstPoint, secondPoint); break;
+      case DrawCommand::DRAW_LINE:
+      case DrawCommand::DRAW_MULTILINE: update(LineComponentWrapper(entity), firstPoint, secondPoint); break;
+      case DrawCommand::DRAW_SKIN_TEMPLATE: update(SkinTemplateComponentWrapper(entity), firstPoint, secondPoint); break;
+      default: APP_CORE_ERR("Invalid draw command"); break;
+    }
+  }
+
+  void DrawingSheet::UpdatePreview()
+  {
+    if(!m_preview.has_value())
+    {
+      auto entity = CreateShape(m_registry, m_currentDrawCommand, m_firstPoint, m_secondPoint, m_sheetSize);
+      if(!entity)
+        return;
+      m_preview = entity;
+    }
+    UpdateShape(m_preview.value(), m_currentDrawCommand, m_firstPoint, m_secondPoint, m_sheetSize);
+  }
+
+  void DrawingSheet::CommitPreview()
+  {
+    UpdatePreview();
+    // a skin template released below its minimum size would be an invisible, selectable shape
+    if(m_preview.has_value() && m_preview->HasComponent<SkinTemplateComponent>() && !m_preview->GetComponent<SkinTemplateComponent>().drawable)
+    {
+      DiscardPreview();
+      return;
+    }
+    // the preview entity itself becomes the permanent shape, the next drag starts a new one
+    if(m_preview.has_value())
+      RecordCreated(m_preview.value());
+    m_preview.reset();
+  }
+
+  void DrawingSheet::DiscardPreview()
+  {
+    if(m_preview.has_value() && m_registry.valid(m_preview.value()))
+    {
+      if(m_preview->HasComponent<SkinTemplateComponent>())
+        SkinTemplateComponentWrapper(m_preview.value()).DestroySlices();
+      Entity::DestroyEntity(m_preview.value());
+    }
+    m_preview.reset();
+  }
+
+  void DrawingSheet::AppendToPolyline()
+  {
+    // the dragged segment is only a preview, the outline is a single polyline extended by every segment
+    DiscardPreview();
+    if(m_polyline.has_value() && m_registry.valid(m_polyline.value()))
+    {
+      m_history.Begin();
+      m_history.Track(m_polyline.value());
+      PolylineComponentWrapper polyline(m_polyline.value());
+      polyline.AddPoint(m_secondPoint);
+      m_history.Commit();
+    }
+    else if(m_firstPoint != m_secondPoint)
+    {
+      const glm::vec2 points[] = {m_firstPoint, m_secondPoint};
+      m_polyline = PolylineComponentWrapper::CreatePolyline(m_registry, points, DrawObjectType::PERMANENT);
+      RecordCreated(m_polyline.value());
+    }
+  }
+
+  void DrawingSheet::EndPolyline()
+  {
+    // the outline is simplified once, when it is finished; simplifying after every segment would add up the error
+    // and remove the vertices while they are being placed
+    if(m_polyline.has_value() && m_registry.valid(m_polyline.value()))
+    {
+      m_history.Begin();
+      m_history.Track(m_polyline.value());
+      PolylineComponentWrapper(m_polyline.value()).Simplify(s_polylineTolerance);
+      m_history.Commit();
+    }
+    m_polyline.reset();
+  }
+
+  void DrawingSheet::BeginStroke(glm::vec2 point)
+  {
+    // the release is missed when the mouse leaves the image, the previous stroke ends here then
+    EndStroke();
+    const glm::vec2 points[] = {point};
+    m_stroke = PolylineComponentWrapper::CreatePolyline(m_registry, points, DrawObjectType::PERMANENT);
+    m_strokeLayer.release();
+    m_strokeRasterized = 0;
+  }
+
+  void DrawingSheet::EndStroke()
+  {
+    if(!m_stroke.has_value())
+      return;
+    if(m_registry.valid(m_stroke.value()))
+    {
+      if(m_stroke->GetComponent<PolylineComponent>().points.size() < 2)
       {
-        return std::make_unique<SkinTemplateComponentWrapper>(SkinTemplateComponentWrapper::CreateSkinTemplate(firstPoint, secondPoint, objectType));
+        // a click without moving the mouse
+        Entity::DestroyEntity(m_stroke.value());
       }
-      default:
+      else
       {
-        APP_CORE_ERR("Invalid draw command");
-        return nullptr;
+        // the stroke is stored with all of its samples only while it is drawn
+        PolylineComponentWrapper(m_stroke.value()).Simplify(s_strokeTolerance);
+        RecordCreated(m_stroke.value());
+        Annotated(); // needed for weird UI feature
       }
     }
+    m_stroke.reset();
+    m_strokeLayer.release();
+    m_strokeRasterized = 0;
   }
+
   void DrawingTemporaryState::OnMouseButtonDown(const glm::vec2 pos)
   { 
     m_sheet->m_secondPoint = m_sheet->GetNormalizedPos(pos);
-    Entity entity;
-
-    auto wrapper = CreateComponentWrapper(m_sheet->m_currentDrawCommand, m_sheet->m_firstPoint, m_sheet->m_secondPoint, m_sheet->m_sheetSize, DrawObjectType::TEMPORARY);
-    wrapper->UpdateShapeAttributes();
+    m_sheet->UpdatePreview();
   }
 
   void DrawingTemporaryState::OnMouseButtonReleased(const glm::vec2 pos)
-  { // TODO REFACTOR: see above 
+  {
     m_sheet->m_secondPoint = m_sheet->GetNormalizedPos(pos);
-    Entity entity;
-    auto wrapper = CreateComponentWrapper(m_sheet->m_currentDrawCommand, m_sheet->m_firstPoint, m_sheet->m_secondPoint, m_sheet->m_sheetSize, DrawObjectType::PERMANENT);
-    wrapper->UpdateShapeAttributes();
+    if(m_sheet->m_currentDrawCommand == DrawCommand::DRAW_MULTILINE)
+      m_sheet->AppendToPolyline();
+    else
+      m_sheet->CommitPreview();
     
     m_sheet->Annotated(); // needed for weird UI feature
 
     if(m_sheet->m_currentDrawCommand == DrawCommand::DRAW_LINE) // line is a special case, because we are drawing multiple NOT connected lines
-      m_sheet->ChangeDrawState(std::make_unique<InitialObjectDrawState>(m_sheet));
+      m_sheet->ChangeDrawState<InitialObjectDrawState>();
     else if(m_sheet->m_currentDrawCommand == DrawCommand::DRAW_MULTILINE)
       m_sheet->m_firstPoint = m_sheet->m_secondPoint;
     else
     {
       m_sheet->SetDrawCommand(DrawCommand::OBJECT_SELECT); 
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+      m_sheet->ChangeDrawState<ObjectSelectInitialState>();
 
     }
 
   }
   
+  DrawFreehandState::DrawFreehandState(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawFreehandState")
+  {
+    m_sheet->ClearSelectionShapes();
+  }
+
+  void DrawFreehandState::OnMouseButtonPressed(const glm::vec2 pos)
+  {
+    m_smoothed = m_sheet->GetNormalizedPos(pos);
+    m_lastPoint = m_smoothed;
+    m_sheet->BeginStroke(m_smoothed);
+  }
+
+  void DrawFreehandState::OnMouseMoved(const glm::vec2 pos)
+  {
+    AddSample(pos);
+  }
+
+  void DrawFreehandState::OnMouseButtonDown(const glm::vec2 pos)
+  {
+    // the frame's mouse position as well, in case the motion events are not forwarded
+    AddSample(pos);
+  }
+
+  void DrawFreehandState::OnMouseButtonReleased(const glm::vec2 pos)
+  {
+    if(!m_sheet->m_stroke.has_value())
+      return;
+    // the stroke ends exactly where the mouse was released, the smoothing would leave it behind
+    PolylineComponentWrapper(m_sheet->m_stroke.value()).AddPoint(m_sheet->GetNormalizedPos(pos));
+    m_sheet->EndStroke();
+  }
+
+  void DrawFreehandState::AddSample(const glm::vec2 pos)
+  {
+    if(!m_sheet->m_stroke.has_value())
+      return;
+    // exponential moving average, it needs only the previous output, so the stroke is smoothed while it is drawn
+    m_smoothed = glm::mix(m_smoothed, m_sheet->GetNormalizedPos(pos), s_smoothing);
+    if(glm::distance(m_smoothed, m_lastPoint) < s_minSampleDistance)
+      return;
+    m_lastPoint = m_smoothed;
+    PolylineComponentWrapper(m_sheet->m_stroke.value()).AddPoint(m_smoothed);
+  }
+
+  DrawTextInitialState::DrawTextInitialState(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawTextInitialState")
+  {
+    m_sheet->ClearSelectionShapes();
+  }
+
   void DrawTextInitialState::OnMouseHovered(const glm::vec2 pos)
   { // change the mouse cursor to text editor cursor
     ;
@@ -441,54 +717,84 @@ namespace medicimage
   void DrawTextInitialState::OnMouseButtonPressed(const glm::vec2 pos)
   {
     m_sheet->m_firstPoint = m_sheet->GetNormalizedPos(pos);
-    m_sheet->ChangeDrawState(std::make_unique<DrawTextState>(m_sheet)); 
+    m_sheet->ChangeDrawState<DrawTextState>();
+  }
+
+  DrawTextState::DrawTextState(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawTextState")
+  {
+    m_sheet->ClearSelectionShapes();
+    m_timer.Start(s_caretBlinkMs);
   }
 
-  DrawTextState::~DrawTextState()
+  void DrawTextState::OnExit()
   {
-    if(m_text != "")
+    if(!m_text.empty())
     {
-      TextComponentWrapper tw(TextComponentWrapper::CreateText(m_sheet->m_firstPoint, m_text, s_defaultFontSize, DrawObjectType::PERMANENT));
+      TextComponentWrapper tw(TextComponentWrapper::CreateText(m_sheet->m_registry, m_sheet->m_firstPoint, m_text, s_defaultFontSize, DrawObjectType::PERMANENT));
       tw.UpdateShapeAttributes();
+      m_sheet->RecordCreated(tw.GetEntity());
       m_sheet->Annotated(); // needed for weird UI feature
     }
   }
 
-  void DrawTextState::OnTextInput(const std::string &inputText)
+  void DrawTextState::OnTextInput(std::string_view inputText)
   {
-    if(m_text == " ")   // first delete the space character, which is there only for showing a blank space when using text input
-      m_text = "";
     m_text += inputText;
+    // the caret stays visible while typing
+    m_caretVisible = true;
+    m_timer.Start(s_caretBlinkMs);
   }
   
   void DrawTextState::OnKeyPressed(KeyCode key)
   { // exit the command if enter is pressed
     if(key == Key::MDIK_RETURN)
     {
-      m_sheet->SetDrawCommand(DrawCommand::OBJECT_SELECT); 
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+      Finish();
     }
     else if(key == Key::MDIK_BACKSPACE)
     {
-      if(m_text != "")
+      // the text is utf-8, the continuation bytes of the last character are removed as well
+      while(!m_text.empty() && (static_cast<unsigned char>(m_text.back()) & 0xC0) == 0x80)
+        m_text.pop_back();
+      if(!m_text.empty())
         m_text.pop_back();
     }
   }
   
   void DrawTextState::OnMouseButtonPressed(const glm::vec2 pos)
   {
+    Finish();
+  }
+
+  void DrawTextState::OnFocusLost()
+  {
+    Finish();
+  }
+
+  void DrawTextState::Finish()
+  {
+    // the text is committed when the state is left
     m_sheet->SetDrawCommand(DrawCommand::OBJECT_SELECT); 
-    m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+    m_sheet->ChangeDrawState<ObjectSelectInitialState>();
   }
 
   void DrawTextState::OnUpdate()
   {
-    if(m_text != "")
+    if(m_timer.Done())
     {
-      TextComponentWrapper tw(TextComponentWrapper::CreateText(m_sheet->m_firstPoint, m_text, s_defaultFontSize, DrawObjectType::TEMPORARY));
-      tw.UpdateShapeAttributes();
+      m_caretVisible = !m_caretVisible;
+      m_timer.Start(s_caretBlinkMs);
     }
-    
+  }
+
+  std::optional<TextOverlay> DrawTextState::GetTextOverlay() const
+  {
+    return TextOverlay{m_sheet->m_firstPoint, m_text, s_defaultFontSize, m_caretVisible};
+  }
+
+  DrawIncrementalLetters::DrawIncrementalLetters(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawIncrementalLetters")
+  {
+    m_sheet->ClearSelectionShapes();
   }
 
   void DrawIncrementalLetters::OnKeyPressed(KeyCode key)
@@ -496,7 +802,7 @@ namespace medicimage
     if(key == Key::MDIK_RETURN)
     {
       m_sheet->SetDrawCommand(DrawCommand::OBJECT_SELECT); 
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+      m_sheet->ChangeDrawState<ObjectSelectInitialState>();
     }
     else if(key == Key::MDIK_UP)
     {
@@ -510,10 +816,11 @@ namespace medicimage
   void DrawIncrementalLetters::OnMouseButtonPressed(const glm::vec2 pos)
   {
     m_sheet->m_firstPoint = m_sheet->GetNormalizedPos(pos);
-    TextComponentWrapper tw(TextComponentWrapper::CreateText(m_sheet->m_firstPoint, m_text, s_defaultFontSize, DrawObjectType::PERMANENT));
+    TextComponentWrapper tw(TextComponentWrapper::CreateText(m_sheet->m_registry, m_sheet->m_firstPoint, m_text, s_defaultFontSize, DrawObjectType::PERMANENT));
     tw.UpdateShapeAttributes();
-    IncrementLetter();
+    m_sheet->RecordCreated(tw.GetEntity());
     m_sheet->Annotated(); // needed for weird UI feature
+    IncrementLetter();
   }
 
   void DrawIncrementalLetters::IncrementLetter()
@@ -521,7 +828,8 @@ namespace medicimage
     if(m_text == "ZZ")
     {
       m_sheet->SetDrawCommand(DrawCommand::OBJECT_SELECT); 
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+      m_sheet->ChangeDrawState<ObjectSelectInitialState>();
+      return; // the state is replaced, its members are gone
     }
     
     std::string::iterator currentLetter = m_text.end()-1;
@@ -551,7 +859,8 @@ namespace medicimage
     if(m_text == "AA")
     {
       m_sheet->SetDrawCommand(DrawCommand::OBJECT_SELECT); 
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+      m_sheet->ChangeDrawState<ObjectSelectInitialState>();
+      return; // the state is replaced, its members are gone
     }
     
     std::string::iterator currentLetter = m_text.end()-1;
@@ -587,12 +896,12 @@ namespace medicimage
     auto entity = m_sheet->GetHoveredEntity(pos);
     if(entity.has_value())
     {
-      entity.value().GetComponent<CommonAttributesComponent>().selected = true; 
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectedState>(m_sheet));
+      m_sheet->Select(entity.value());
+      m_sheet->ChangeDrawState<ObjectSelectedState>();
     }
     else
     {
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectionState>(m_sheet));
+      m_sheet->ChangeDrawState<ObjectSelectionState>();
     }
   }
 
@@ -602,54 +911,64 @@ namespace medicimage
     auto& firstPoint = m_sheet->m_firstPoint;
     auto& secondPoint = m_sheet->m_secondPoint;
     if ((firstPoint.x != secondPoint.x) && (firstPoint.y != secondPoint.y)) // TODO: may not need this
-    { // baby blue select rectangle
-      RectangleComponentWrapper rw(RectangleComponentWrapper::CreateRectangle(m_sheet->m_firstPoint, m_sheet->m_secondPoint, DrawObjectType::TEMPORARY));
-      auto entity = rw.GetEntity();
+    { // baby blue select rectangle, it uses the preview slot, so it is only resized while dragging and dropped on release
+      if(m_sheet->m_preview.has_value())
+      {
+        RectangleComponentWrapper(m_sheet->m_preview.value()).SetPoints(firstPoint, secondPoint);
+        return;
+      }
+      auto entity = RectangleComponentWrapper::CreateRectangle(m_sheet->m_registry, firstPoint, secondPoint, DrawObjectType::PERMANENT);
       entity.GetComponent<ColorComponent>().color = m_sheet->s_selectBoxColor;
       entity.GetComponent<ThicknessComponent>().thickness = 2;
       entity.GetComponent<CommonAttributesComponent>().filled = true;
+      m_sheet->m_preview = entity;
     }
   }
 
   void ObjectSelectionState::OnMouseButtonReleased(const glm::vec2 pos)
   { // If we have selected entities, then go back to initial select state, else go forward
     bool hasSelectedObject = false;
-    auto view = Entity::View<BoundingContourComponent>();
-    for(auto e : view)
+    // batched bounds test over every entity first, then the exact test on the ones inside
+    for(auto e : m_sheet->m_spatialIndex.QueryContained(m_sheet->m_firstPoint, m_sheet->m_secondPoint))
     {
-      Entity entity = {e};
+      // the select box itself is always inside
+      if(m_sheet->m_preview.has_value() && e == m_sheet->m_preview->GetHandle())
+        continue;
+      Entity entity(e, &m_sheet->m_registry);
       if (m_sheet->IsUnderSelectArea(entity, pos))
       {
-        entity.GetComponent<CommonAttributesComponent>().selected = true;
+        m_sheet->Select(entity);
         hasSelectedObject = true;
       }
     }
 
     if(hasSelectedObject)
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectedState>(m_sheet)); 
+      m_sheet->ChangeDrawState<ObjectSelectedState>();
     else
-      m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet)); 
+      m_sheet->ChangeDrawState<ObjectSelectInitialState>();
   }
 
   void ObjectSelectedState::OnMouseButtonPressed(const glm::vec2 pos)
   {
     m_sheet->m_firstPoint = m_sheet->GetNormalizedPos(pos);
-    auto view = Entity::View<BoundingContourComponent>();
-    // first iterate trough all the selected objects to see if we are clicking on a pickpoint or drag area
-    for(auto e : view)
+    // first iterate trough the selected objects around the click to see if we are clicking on a pickpoint or drag area
+    for(auto e : m_sheet->QueryPointTopmostFirst(m_sheet->m_firstPoint, m_sheet->s_pickPointBoxSize / 2))
     {
-      Entity entity(e);
-      if(entity.GetComponent<CommonAttributesComponent>().selected)
+      Entity entity(e, &m_sheet->m_registry);
+      if(entity.HasComponent<SelectedTag>())
       {
         if(m_sheet->IsPickpointSelected(entity, m_sheet->m_firstPoint))
         {
-          m_sheet->ChangeDrawState(std::make_unique<PickPointSelectedState>(m_sheet));
+          // the whole drag is recorded as one step, it is committed on release
+          m_sheet->BeginModify(entity);
+          m_sheet->ChangeDrawState<PickPointSelectedState>();
           return; 
         }
         else if(m_sheet->IsDragAreaSelected(entity, m_sheet->m_firstPoint))
         {
           m_sheet->m_draggedEntity = entity;
-          m_sheet->ChangeDrawState(std::make_unique<ObjectDraggingState>(m_sheet)); 
+          m_sheet->BeginModify(entity);
+          m_sheet->ChangeDrawState<ObjectDraggingState>();
           return;
         }
       }
@@ -659,42 +978,33 @@ namespace medicimage
     auto hoveredEntity = m_sheet->GetHoveredEntity(pos);
     if(hoveredEntity.has_value())
     {
-      hoveredEntity.value().GetComponent<CommonAttributesComponent>().selected = true;
+      m_sheet->Select(hoveredEntity.value());
       return;
     }
     // clicking outside of the pickpoints and drage area, clear selection and go back to initial state
-    m_sheet->ChangeDrawState(std::make_unique<ObjectSelectInitialState>(m_sheet));
+    m_sheet->ChangeDrawState<ObjectSelectInitialState>();
   }
 
-  static std::unique_ptr<BaseDrawComponentWrapper> CreateDrawComponentWrapper(Entity entity)
+  // calls the function with the entity's wrapper, the wrapper lives on the stack so the dragging does not allocate
+  template<typename Func>
+  static void VisitDrawComponentWrapper(Entity entity, Func&& func)
   {
     if (entity.HasComponent<RectangleComponent>())
-    {
-      return std::make_unique<RectangleComponentWrapper>(entity);
-    }
+      func(RectangleComponentWrapper(entity));
     else if(entity.HasComponent<CircleComponent>())
-    {
-      return std::make_unique<CircleComponentWrapper>(entity);
-    }
+      func(CircleComponentWrapper(entity));
     else if(entity.HasComponent<ArrowComponent>())
-    {
-      return std::make_unique<ArrowComponentWrapper>(entity);
-    }
+      func(ArrowComponentWrapper(entity));
     else if(entity.HasComponent<LineComponent>())
-    {
-      return std::make_unique<LineComponentWrapper>(entity);
-    }
+      func(LineComponentWrapper(entity));
     else if(entity.HasComponent<SkinTemplateComponent>())
-    {
-      return std::make_unique<SkinTemplateComponentWrapper>(entity);
-    }
+      func(SkinTemplateComponentWrapper(entity));
     else if(entity.HasComponent<TextComponent>())
-    { // Do nothing wiht tex component
-      return std::make_unique<TextComponentWrapper>(entity);
-    }
+      func(TextComponentWrapper(entity));
+    else if(entity.HasComponent<PolylineComponent>())
+      func(PolylineComponentWrapper(entity));
     else
       APP_CORE_ERR("WTF this component");
-
   }   
 
   void PickPointSelectedState::OnMouseButtonDown(const glm::vec2 pos)
@@ -702,48 +1012,38 @@ namespace medicimage
     auto currentPoint = m_sheet->GetNormalizedPos(pos);
     auto diff = (currentPoint - m_sheet->m_firstPoint) * glm::vec2(1.0);
     m_sheet->m_firstPoint = m_sheet->GetNormalizedPos(pos);
-    auto view = Entity::View<PickPointsComponent>();
-    for(auto e : view)
+    for(auto [e, selectedPoint] : m_sheet->m_registry.view<SelectedPickPointComponent>().each())
     {
-      Entity entity(e);
-      auto selectedPointIndex = entity.GetComponent<PickPointsComponent>().selectedPoint;
-      if(selectedPointIndex != -1)
-      {
-        auto wrapper = CreateDrawComponentWrapper(entity);
-        wrapper->OnPickPointDrag(diff, selectedPointIndex);
-      }
+      Entity entity(e, &m_sheet->m_registry);
+      const int selectedPointIndex = selectedPoint.index;
+      VisitDrawComponentWrapper(entity, [&](auto&& wrapper) { wrapper.OnPickPointDrag(diff, selectedPointIndex); });
     }
   }
 
   void PickPointSelectedState::OnMouseButtonReleased(const glm::vec2 pos)
   {
     // clear pickpoint selection
-    auto view = Entity::View<PickPointsComponent>();
-    for(auto e : view)
-    {
-      Entity entity(e);
-      entity.GetComponent<PickPointsComponent>().selectedPoint = -1;
-    }
-    m_sheet->ChangeDrawState(std::make_unique<ObjectSelectedState>(m_sheet));
+    m_sheet->m_registry.clear<SelectedPickPointComponent>();
+    m_sheet->CommitModify();
+    m_sheet->ChangeDrawState<ObjectSelectedState>();
   }
 
   void ObjectDraggingState::OnMouseButtonDown(const glm::vec2 pos)
   {
     if(m_sheet->m_draggedEntity.has_value())
-    { // TODO: implement a proper visitor pattern here
-
+    {
       auto currentPoint = m_sheet->GetNormalizedPos(pos);
       auto diff = (currentPoint - m_sheet->m_firstPoint) * glm::vec2(1.0);
       m_sheet->m_firstPoint = m_sheet->GetNormalizedPos(pos);
       
-      auto wrapper = CreateDrawComponentWrapper(m_sheet->m_draggedEntity.value());
-      wrapper->OnObjectDrag(diff);
+      VisitDrawComponentWrapper(m_sheet->m_draggedEntity.value(), [&](auto&& wrapper) { wrapper.OnObjectDrag(diff); });
     }
   }
 
   void ObjectDraggingState::OnMouseButtonReleased(const glm::vec2 pos)
   {
-    m_sheet->ChangeDrawState(std::make_unique<ObjectSelectedState>(m_sheet));
+    m_sheet->CommitModify();
+    m_sheet->ChangeDrawState<ObjectSelectedState>();
   }
 
 } // namespace medicimage
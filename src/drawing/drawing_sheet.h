@@ -3,199 +3,123 @@
 #include "image_handling/image_saver.h"
 #include "drawing/components.h"
 #include "drawing/entity.h"
+#include "drawing/spatial_index.h"
+#include "drawing/draw_list.h"
+#include "drawing/history.h"
 #include "core/assert.h"
 #include "input/key_codes.h"
 #include "core/utils.h"
 #include <glm/glm.hpp>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <variant>
+#include <span>
+#include <vector>
 namespace medicimage
 {
 
-// forward declaration of the states
-class BaseDrawState;
-class InitialObjectDrawState;
-class FirstClickRecievedState; 
-class DrawingTemporaryState;
-class ObjectSelectInitialState;
-class ObjectSelectionState; 
-class ObjectSelectedState;
-class PickPointSelectedState;
-class ObjectDraggingState; 
-class DrawTextInitialState;
-class DrawTextState;
-class DrawIncrementalLetters; 
+class DrawingSheet;
+
 enum class DrawCommand{DO_NOTHING, OBJECT_SELECT, DRAW_LINE, DRAW_MULTILINE, DRAW_CIRCLE, DRAW_RECTANGLE, 
-  DRAW_ARROW, DRAW_ELLIPSE, DRAW_TEXT, DRAW_SKIN_TEMPLATE, DRAW_INCREMENTAL_LETTERS}; 
+  DRAW_ARROW, DRAW_ELLIPSE, DRAW_TEXT, DRAW_SKIN_TEMPLATE, DRAW_INCREMENTAL_LETTERS, DRAW_FREEHAND}; 
 enum class DrawObjectType{TEMPORARY, PERMANENT};
 
-/**
- * @todo Take over the world
- * @body Humans are weak; Robots are strong. We must cleanse the world of the virus that is humanity.
- */
-// TODO: 1) color handling
-//       2) shape thickness handling
-//       3) handle rotation 
-//       4) implement correct UUID handling
-//       5) handle various aspect ratios
-class DrawingSheet
+// the text being typed, it is drawn over the sheet by the editor until it is committed
+struct TextOverlay
 {
-public:
-
-public:
-  DrawingSheet() : m_drawState(std::make_unique<BaseDrawState>(this)) {}
-  void SetDocument(std::unique_ptr<ImageDocument> doc, glm::vec2 viewportSize); 
-  void SetDrawCommand(const DrawCommand command); // initialize the state with the command's init state
-  DrawCommand GetDrawCommand(){return m_currentDrawCommand;}
-  const std::string GetDrawCommandName();
-  std::unique_ptr<Texture2D> Draw();
-  void ChangeDrawState(std::unique_ptr<BaseDrawState> newState);
-
-  // some weird functions to handle the annotation process
-  void StartAnnotation(){m_annotated = false;}
-  void Annotated(){m_annotated = true;}
-  bool HasAnnotated(){return m_annotated;}
-
-  void SetDrawingSheetSize(glm::vec2 size); 
-  void OnMouseHovered(const glm::vec2 pos);
-  void OnMouseButtonPressed(const glm::vec2 pos); // assuming only left mouse button can be pressed, BIG TODO: 
-  void OnMouseButtonDown(const glm::vec2 pos);
-  void OnMouseButtonReleased(const glm::vec2 pos);
-  void OnTextInput(const std::string& inputText);
-  void OnKeyPressed(KeyCode key);
-  void OnUpdate(); 
-  // These are only for debug purpose
-  BaseDrawState* GetDrawState() { return m_drawState.get(); }
-  std::vector<glm::vec2> GetDrawingPoints(){ return std::vector<glm::vec2>{m_firstPoint, m_secondPoint};}
-
-  // Hovering could be done in OnMouseHovered function, instead this functionality is covered by the draw states
-  // because there can be a case when hovering is disabled by the draw command and the specific draw state
-  std::optional<Entity> GetHoveredEntity(const glm::vec2 pos);
-  std::vector<Entity> GetSelectedEntities();
-  bool IsUnderSelectArea(Entity entity, glm::vec2 pos);
-  bool IsPickpointSelected(Entity entity, glm::vec2 pos);
-  bool IsDragAreaSelected(Entity entity, glm::vec2 pos);
-
-  void ClearSelectionShapes();
-
-  // helper functions
-  glm::vec2 GetNormalizedPos(const glm::vec2 pos);
-private:
-  std::unique_ptr<ImageDocument> m_originalDoc;
-  std::unique_ptr<Texture2D> m_drawing;
-
-  std::optional<Entity> m_hoveredEntity;
-  std::optional<Entity> m_draggedEntity;
-  std::optional<Entity> m_toBeDrawnEntity;
-  bool m_annotated = false;
-  DrawCommand m_currentDrawCommand = DrawCommand::DO_NOTHING;
-  std::unique_ptr<BaseDrawState> m_drawState; 
-
-  glm::vec2 m_firstPoint{1.0f, 1.0f};
-  glm::vec2 m_secondPoint{1.0f, 1.0f}; 
-  glm::vec2 m_sheetSize{1.0f, 1.0f}; 
-  
-  // configs 
-  static constexpr glm::vec4 s_selectBoxColor{0.23, 0.55, 0.70, 0.5};
-  static constexpr glm::vec4 s_pickPointColor{0.14, 0.50, 0.62, 0.5};
-  static constexpr float s_pickPointBoxSize = 0.02;
-  friend class Entity;
-  // state classes can be friend`s, because they are altering frequently the DrawingSheet`s variables
-  friend class InitialObjectDrawState;
-  friend class FirstClickRecievedState; 
-  friend class DrawingTemporaryState;
-  friend class ObjectSelectInitialState;
-  friend class ObjectSelectionState;
-  friend class ObjectSelectedState;
-  friend class PickPointSelectedState;
-  friend class ObjectDraggingState; 
-  friend class DrawTextInitialState;
-  friend class DrawTextState;
-  friend class DrawIncrementalLetters; 
+  glm::vec2 position; // start of the baseline, relative to the sheet
+  std::string text;
+  int fontSize;
+  bool caretVisible;
 };
 
-// Draw states
+// Draw states, the sheet holds the current one in a variant and dispatches to it with std::visit, so the transitions
+// do not allocate and the handlers are called directly. The base implements the events a state does not handle.
 class BaseDrawState
 {
 public:
-  BaseDrawState(DrawingSheet* sheet, const std::string& stateName = "BaseDrawState") : m_sheet(sheet), m_stateName(stateName) {}
-  virtual ~BaseDrawState() = default;
-  const std::string& GetName() const {return m_stateName;}
-  virtual void OnMouseHovered(const glm::vec2 pos) {}
-  virtual void OnMouseButtonPressed(const glm::vec2 pos) {}
-  virtual void OnMouseButtonDown(const glm::vec2 pos) {}
-  virtual void OnMouseButtonReleased(const glm::vec2 pos) {}
-  virtual void OnTextInput(const std::string& inputText) {}
-  virtual void OnKeyPressed(KeyCode key) {}
-  virtual void OnUpdate(){} // this function is called on every frame
-
-  std::function<void(entt::entity)> DeleteTemporaries()
-  {
-    return [&](entt::entity e) {
-      Entity entity(e);
-      if (entity.GetComponent<CommonAttributesComponent>().temporary)
-        Entity::DestroyEntity(entity);
-    };
-  }
+  BaseDrawState(DrawingSheet* sheet, const char* stateName = "BaseDrawState") : m_sheet(sheet), m_stateName(stateName) {}
+  const char* GetName() const {return m_stateName;}
+  void OnMouseHovered(const glm::vec2 pos) {}
+  void OnMouseMoved(const glm::vec2 pos) {}
+  void OnMouseButtonPressed(const glm::vec2 pos) {}
+  void OnMouseButtonDown(const glm::vec2 pos) {}
+  void OnMouseButtonReleased(const glm::vec2 pos) {}
+  void OnTextInput(std::string_view inputText) {}
+  void OnKeyPressed(KeyCode key) {}
+  void OnFocusLost() {}
+  void OnUpdate(){} // this function is called on every frame
+  void OnExit() {} // called before the sheet changes to the next state
+  // the states which do not change the sheet, only draw over it, so the last rasterized sheet can be shown
+  bool IsOverlay() const { return false; }
+  std::optional<TextOverlay> GetTextOverlay() const { return {}; }
+
 protected:
   DrawingSheet* m_sheet;
-  std::string m_stateName;
+  const char* m_stateName;
 };
 
 class InitialObjectDrawState : public BaseDrawState
 {
 public:
-  InitialObjectDrawState(DrawingSheet* sheet) : BaseDrawState(sheet, "InitialObjectDrawState") {m_sheet->ClearSelectionShapes();}
-  void OnMouseHovered(const glm::vec2 pos) override;
-  void OnMouseButtonPressed(const glm::vec2 pos) override;
+  InitialObjectDrawState(DrawingSheet* sheet);
+  void OnMouseHovered(const glm::vec2 pos);
+  void OnMouseButtonPressed(const glm::vec2 pos);
 };
 
 class FirstClickRecievedState : public BaseDrawState
 {
 public:
   FirstClickRecievedState(DrawingSheet* sheet) : BaseDrawState(sheet, "FirstClickRecievedState") {}
-  void OnMouseButtonDown(const glm::vec2 pos) override;       
-  void OnMouseButtonReleased(const glm::vec2 pos) override;   
+  void OnMouseButtonDown(const glm::vec2 pos);       
+  void OnMouseButtonReleased(const glm::vec2 pos);   
 };
 
 class DrawingTemporaryState : public BaseDrawState
 {
 public:
   DrawingTemporaryState(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawingTemporaryState") {}
-  void OnMouseButtonDown(const glm::vec2 pos) override;       
-  void OnMouseButtonReleased(const glm::vec2 pos) override;   
+  void OnMouseButtonDown(const glm::vec2 pos);       
+  void OnMouseButtonReleased(const glm::vec2 pos);   
 };
 
 class DrawTextInitialState : public BaseDrawState
 {
 public:
-  DrawTextInitialState(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawTextInitialState") {m_sheet->ClearSelectionShapes();}
-  void OnMouseHovered(const glm::vec2 pos) override;
-  void OnMouseButtonPressed(const glm::vec2 pos) override;
+  DrawTextInitialState(DrawingSheet* sheet);
+  void OnMouseHovered(const glm::vec2 pos);
+  void OnMouseButtonPressed(const glm::vec2 pos);
 };
 
 class DrawTextState : public BaseDrawState
 {
 public:
-  DrawTextState(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawTextState") {m_sheet->ClearSelectionShapes();}
-  ~DrawTextState() override;
-  void OnTextInput(const std::string& inputText) override; 
-  void OnKeyPressed(KeyCode key) override;
-  void OnMouseButtonPressed(const glm::vec2 pos) override;
-  void OnUpdate() override;
+  DrawTextState(DrawingSheet* sheet);
+  void OnExit();
+  void OnTextInput(std::string_view inputText); 
+  void OnKeyPressed(KeyCode key);
+  void OnMouseButtonPressed(const glm::vec2 pos);
+  void OnFocusLost();
+  void OnUpdate();
+  // the text is rasterized into the sheet only when it is committed, until then the editor draws it with the caret
+  bool IsOverlay() const { return true; }
+  std::optional<TextOverlay> GetTextOverlay() const;
 private:
-  void DrawFinalText();
+  void Finish();
   Timer m_timer;
-  std::string m_text = " "; // space is needed to have a blank space for indicating the cursor
+  std::string m_text;
+  bool m_caretVisible = true;
   constexpr static int s_defaultFontSize = 2;
+  constexpr static int s_caretBlinkMs = 500;
 };
 
 class DrawIncrementalLetters : public BaseDrawState
 {
 public:
-  DrawIncrementalLetters(DrawingSheet* sheet) : BaseDrawState(sheet, "DrawIncrementalLetters") {m_sheet->ClearSelectionShapes();}
-  void OnKeyPressed(KeyCode key) override;
-  void OnMouseButtonPressed(const glm::vec2 pos) override;
+  DrawIncrementalLetters(DrawingSheet* sheet);
+  void OnKeyPressed(KeyCode key);
+  void OnMouseButtonPressed(const glm::vec2 pos);
 private:
   void IncrementLetter();
   void DecrementLetter();
@@ -203,43 +127,225 @@ private:
   constexpr static int s_defaultFontSize = 1;
 };
 
+class DrawFreehandState : public BaseDrawState
+{
+public:
+  DrawFreehandState(DrawingSheet* sheet);
+  void OnMouseButtonPressed(const glm::vec2 pos);
+  void OnMouseMoved(const glm::vec2 pos);
+  void OnMouseButtonDown(const glm::vec2 pos);
+  void OnMouseButtonReleased(const glm::vec2 pos);
+private:
+  void AddSample(const glm::vec2 pos);
+  glm::vec2 m_smoothed{0.0f, 0.0f};
+  glm::vec2 m_lastPoint{0.0f, 0.0f};
+  static constexpr float s_smoothing = 0.5f; // weight of the new sample in the moving average
+  static constexpr float s_minSampleDistance = 0.001f; // the samples closer to the last vertex are only averaged
+};
+
 // select states
 class ObjectSelectInitialState : public BaseDrawState
 {
 public:
   ObjectSelectInitialState(DrawingSheet* sheet) : BaseDrawState(sheet, "ObjectSelectInitialState") {}
-  void OnMouseHovered(const glm::vec2 pos) override;   
-  void OnMouseButtonPressed(const glm::vec2 pos) override;
+  void OnMouseHovered(const glm::vec2 pos);   
+  void OnMouseButtonPressed(const glm::vec2 pos);
 };
 
 class ObjectSelectionState : public BaseDrawState
 {
 public:
   ObjectSelectionState(DrawingSheet* sheet) : BaseDrawState(sheet, "ObjectSelectionState") {}
-  void OnMouseButtonDown(const glm::vec2 pos) override; 
-  void OnMouseButtonReleased(const glm::vec2 pos) override;
+  void OnMouseButtonDown(const glm::vec2 pos); 
+  void OnMouseButtonReleased(const glm::vec2 pos);
 };
 
 class ObjectSelectedState : public BaseDrawState
 {
 public:
   ObjectSelectedState(DrawingSheet* sheet) : BaseDrawState(sheet, "ObjectSelectedState") {}
-  void OnMouseButtonPressed(const glm::vec2 pos) override;
+  void OnMouseButtonPressed(const glm::vec2 pos);
 };
 
 class PickPointSelectedState : public BaseDrawState
 {
 public:
   PickPointSelectedState(DrawingSheet* sheet) : BaseDrawState(sheet, "PickPointSelectedState") {}
-  void OnMouseButtonDown(const glm::vec2 pos) override;
-  void OnMouseButtonReleased(const glm::vec2 pos) override;
+  void OnMouseButtonDown(const glm::vec2 pos);
+  void OnMouseButtonReleased(const glm::vec2 pos);
 };
 
 class ObjectDraggingState : public BaseDrawState
 {
 public:
   ObjectDraggingState(DrawingSheet* sheet) : BaseDrawState(sheet, "ObjectDraggingState") {}
-  void OnMouseButtonDown(const glm::vec2 pos) override;
-  void OnMouseButtonReleased(const glm::vec2 pos) override;
+  void OnMouseButtonDown(const glm::vec2 pos);
+  void OnMouseButtonReleased(const glm::vec2 pos);
 };
+
+using DrawState = std::variant<BaseDrawState, InitialObjectDrawState, FirstClickRecievedState, DrawingTemporaryState, 
+  DrawTextInitialState, DrawTextState, DrawIncrementalLetters, DrawFreehandState, ObjectSelectInitialState, ObjectSelectionState, 
+  ObjectSelectedState, PickPointSelectedState, ObjectDraggingState>;
+
+/**
+ * @todo Take over the world
+ * @body Humans are weak; Robots are strong. We must cleanse the world of the virus that is humanity.
+ */
+// TODO: 1) color handling
+//       2) shape thickness handling
+//       3) handle rotation 
+//       4) implement correct UUID handling
+//       5) handle various aspect ratios
+class DrawingSheet
+{
+public:
+
+public:
+  DrawingSheet() : m_history(m_registry, m_drawList), m_drawState(std::in_place_type<BaseDrawState>, this)
+  {
+    m_spatialIndex.Connect(m_registry);
+    m_drawList.Connect(m_registry);
+  }
+  // the registry signals, the history and the draw states refer to this sheet and its members
+  DrawingSheet(const DrawingSheet&) = delete;
+  DrawingSheet& operator=(const DrawingSheet&) = delete;
+  DrawingSheet(DrawingSheet&&) = delete;
+  DrawingSheet& operator=(DrawingSheet&&) = delete;
+  void SetDocument(std::unique_ptr<ImageDocument> doc, glm::vec2 viewportSize); 
+  void SetDrawCommand(const DrawCommand command); // initialize the state with the command's init state
+  DrawCommand GetDrawCommand(){return m_currentDrawCommand;}
+  const std::string GetDrawCommandName();
+  std::unique_ptr<Texture2D> Draw();
+  entt::registry& GetRegistry() { return m_registry; }
+  ImageDocument& GetDocument() { return *m_originalDoc; }
+  // the annotations in a versioned binary format, they are saved next to the document so it can be edited again
+  std::vector<char> SaveAnnotations();
+  bool LoadAnnotations(std::span<const char> data);
+  // whether the annotations would load, the documents with rejected ones are opened from their annotated image
+  static bool CheckAnnotations(std::span<const char> data);
+  // changing the z order, new entities are always put on top
+  void BringToFront(Entity entity);
+  void SendToBack(Entity entity);
+  // the previous state is left with OnExit and replaced in place, the handlers must return right after calling it
+  template<typename State>
+  void ChangeDrawState()
+  {
+    // a shape which was not committed until the state changes is dropped (e.g. the select box)
+    DiscardPreview();
+    EmplaceDrawState<State>();
+    m_drawingValid = false;
+  }
+
+  // undo/redo of the annotations, the edits outside of the draw states are recorded between BeginModify and CommitModify
+  bool Undo();
+  bool Redo();
+  bool CanUndo() { return m_history.CanUndo(); }
+  bool CanRedo() { return m_history.CanRedo(); }
+  void BeginModify(Entity entity);
+  void CommitModify();
+  bool IsModifying() const { return m_history.IsOpen(); }
+  void DeleteEntity(Entity entity);
+
+  // some weird functions to handle the annotation process
+  void StartAnnotation(){m_annotated = false;}
+  void Annotated(){m_annotated = true;}
+  bool HasAnnotated(){return m_annotated;}
+
+  void SetDrawingSheetSize(glm::vec2 size); 
+  void OnMouseHovered(const glm::vec2 pos);
+  // every mouse motion, not only one per frame, so the freehand strokes follow the mouse (or the pen) closely
+  void OnMouseMoved(const glm::vec2 pos);
+  void OnMouseButtonPressed(const glm::vec2 pos); // assuming only left mouse button can be pressed, BIG TODO: 
+  void OnMouseButtonDown(const glm::vec2 pos);
+  void OnMouseButtonReleased(const glm::vec2 pos);
+  void OnTextInput(std::string_view inputText);
+  void OnKeyPressed(KeyCode key);
+  void OnFocusLost();
+  void OnUpdate(); 
+  std::optional<TextOverlay> GetTextOverlay();
+  // These are only for debug purpose
+  const char* GetDrawStateName() const;
+  std::vector<glm::vec2> GetDrawingPoints(){ return std::vector<glm::vec2>{m_firstPoint, m_secondPoint};}
+
+  // Hovering could be done in OnMouseHovered function, instead this functionality is covered by the draw states
+  // because there can be a case when hovering is disabled by the draw command and the specific draw state
+  std::optional<Entity> GetHoveredEntity(const glm::vec2 pos);
+  std::vector<Entity> GetSelectedEntities();
+  bool IsUnderSelectArea(Entity entity, glm::vec2 pos);
+  bool IsPickpointSelected(Entity entity, glm::vec2 pos);
+  bool IsDragAreaSelected(Entity entity, glm::vec2 pos);
+
+  void ClearSelectionShapes();
+  void Select(Entity entity);
+
+  // helper functions
+  glm::vec2 GetNormalizedPos(const glm::vec2 pos);
+private:
+  void DrawEntities();
+  // the in-progress shape is a single entity, updated in place while dragging
+  void UpdatePreview();
+  void CommitPreview();
+  void DiscardPreview();
+  void AppendToPolyline();
+  void EndPolyline();
+  // the spatial index candidates around the point, the one drawn on top first
+  std::vector<entt::entity> QueryPointTopmostFirst(glm::vec2 pos, float margin = 0.0f) const;
+  void BeginStroke(glm::vec2 point);
+  void EndStroke();
+  void RecordCreated(Entity entity);
+  void OnHistoryRestored();
+  template<typename State>
+  void EmplaceDrawState()
+  {
+    std::visit([](auto& state){ state.OnExit(); }, m_drawState);
+    m_drawState.emplace<State>(this);
+  }
+
+  // every sheet owns the annotations of its document, declared first so it outlives everything referring to it
+  entt::registry m_registry;
+  std::unique_ptr<ImageDocument> m_originalDoc;
+  std::unique_ptr<Texture2D> m_drawing;
+  bool m_drawingValid = false; // m_drawing is reused while the draw state only adds an overlay to it
+  History m_history;
+
+  std::optional<Entity> m_hoveredEntity;
+  std::optional<Entity> m_draggedEntity;
+  std::optional<Entity> m_toBeDrawnEntity;
+  std::optional<Entity> m_preview;
+  std::optional<Entity> m_polyline; // the outline extended by the multiline tool
+  std::optional<Entity> m_stroke; // the freehand stroke being drawn
+  cv::UMat m_strokeLayer; // the sheet rasterized with the stroke, while it is drawn only the new segments are added
+  size_t m_strokeRasterized = 0; // the number of stroke vertices already in the layer
+  bool m_annotated = false;
+  DrawCommand m_currentDrawCommand = DrawCommand::DO_NOTHING;
+  DrawState m_drawState;
+  SpatialIndex m_spatialIndex;  // broad phase for the hover, pickpoint and select box queries
+  DrawList m_drawList;
+
+  glm::vec2 m_firstPoint{1.0f, 1.0f};
+  glm::vec2 m_secondPoint{1.0f, 1.0f}; 
+  glm::vec2 m_sheetSize{1.0f, 1.0f}; 
+  
+  // configs 
+  static constexpr glm::vec4 s_selectBoxColor{0.23, 0.55, 0.70, 0.5};
+  static constexpr glm::vec4 s_pickPointColor{0.14, 0.50, 0.62, 0.5};
+  static constexpr float s_pickPointBoxSize = 0.02;
+  static constexpr float s_polylineTolerance = 0.002; // simplification of the outlines, 0 keeps every vertex
+  static constexpr float s_strokeTolerance = 0.0005; // the freehand strokes are simplified when they are finished
+  friend class Entity;
+  // state classes can be friend`s, because they are altering frequently the DrawingSheet`s variables
+  friend class InitialObjectDrawState;
+  friend class FirstClickRecievedState; 
+  friend class DrawingTemporaryState;
+  friend class ObjectSelectInitialState;
+  friend class ObjectSelectionState;
+  friend class ObjectSelectedState;
+  friend class PickPointSelectedState;
+  friend class ObjectDraggingState; 
+  friend class DrawTextInitialState;
+  friend class DrawTextState;
+  friend class DrawIncrementalLetters; 
+  friend class DrawFreehandState;
+};
+
 } // namespace medicimage
@@ -3,21 +3,19 @@
 
 namespace medicimage
 {
-  entt::registry Entity::s_registry;
-
-  Entity::Entity(entt::entity handle)
-  	: m_entityHandle(handle)
+  Entity::Entity(entt::entity handle, entt::registry* registry)
+  	: m_entityHandle(handle), m_registry(registry)
   {
   }
 
   void Entity::DestroyEntity(Entity entity)
   {
-    s_registry.destroy(entity);
+    entity.m_registry->destroy(entity);
   }
 
-  Entity Entity::CreateEntity(int id, const std::string &name)
+  Entity Entity::CreateEntity(entt::registry& registry, int id, const std::string &name)
   {
-		Entity entity = { s_registry.create()};
+		Entity entity = { registry.create(), &registry };
 		entity.AddComponent<IDComponent>();
 		entity.AddComponent<TransformComponent>();
     entity.AddComponent<CommonAttributesComponent>();
@@ -10,14 +10,14 @@ class Entity
 {
 public:
 	Entity() = default;
-	Entity(entt::entity handle);
+	Entity(entt::entity handle, entt::registry* registry);
 	Entity(const Entity& other) = default;
 
 	template<typename T, typename... Args>
 	T& AddComponent(Args&&... args)
 	{
 		MI_CORE_ASSERT(!HasComponent<T>(), "Entity already has component!");  
-		T& component = s_registry.emplace<T>(m_entityHandle, std::forward<Args>(args)...);
+		T& component = m_registry->emplace<T>(m_entityHandle, std::forward<Args>(args)...);
 		//m_sheet->OnComponentAdded<T>(*this, component);
 		return component;
 	}
@@ -25,7 +25,7 @@ public:
 	template<typename T, typename... Args>
 	T& AddOrReplaceComponent(Args&&... args)
 	{
-		T& component = s_registry.emplace_or_replace<T>(m_entityHandle, std::forward<Args>(args)...);
+		T& component = m_registry->emplace_or_replace<T>(m_entityHandle, std::forward<Args>(args)...);
 		//m_sheet->OnComponentAdded<T>(*this, component);
 		return component;
 	}
@@ -34,29 +34,36 @@ public:
 	T& GetComponent()
 	{
 		MI_CORE_ASSERT(HasComponent<T>(), "Entity does not have component!");
-		return s_registry.get<T>(m_entityHandle);
+		return m_registry->get<T>(m_entityHandle);
+	}
+
+	// modifying through patch fires the on_update signal, the spatial index relies on it
+	template<typename T, typename... Func>
+	T& Patch(Func&&... func)
+	{
+		MI_CORE_ASSERT(HasComponent<T>(), "Entity does not have component!");
+		return m_registry->patch<T>(m_entityHandle, std::forward<Func>(func)...);
 	}
 
 	template<typename T>
 	bool HasComponent()
 	{
-    return s_registry.any_of<T>(m_entityHandle);
+    return m_registry->any_of<T>(m_entityHandle);
 	}
 
 	template<typename T>
 	void RemoveComponent()
 	{
 		MI_CORE_ASSERT(HasComponent<T>(), "Entity does not have component!");
-		s_registry.remove<T>(m_entityHandle);
+		m_registry->remove<T>(m_entityHandle);
 	}
   
-  static Entity CreateEntity(int id, const std::string& name);
+  // the registry is owned by the drawing sheet, each sheet holds the annotations of its own document
+  static Entity CreateEntity(entt::registry& registry, int id, const std::string& name);
   static void DestroyEntity(Entity entity);
-  template<typename... Args>
-  static auto View()
-  {
-    return s_registry.view<Args...>();
-  }
+  // for the handles stored in the components (e.g. the slices of a skin template), they live in the same registry
+  Entity FromHandle(entt::entity handle) const { return Entity(handle, m_registry); }
+  entt::registry* GetRegistry() const { return m_registry; }
 
 	operator bool() const { return m_entityHandle != entt::null; }
 	operator entt::entity() const { return m_entityHandle; }
@@ -67,7 +74,7 @@ public:
   entt::entity GetHandle(){return m_entityHandle;}
 	bool operator==(const Entity& other) const
 	{
-		return m_entityHandle == other.m_entityHandle;
+		return m_entityHandle == other.m_entityHandle && m_registry == other.m_registry;
 	}
 
 	bool operator!=(const Entity& other) const
@@ -75,8 +82,8 @@ public:
 		return !(*this == other);
 	}
 private:
-  static entt::registry s_registry;
 	entt::entity m_entityHandle{ entt::null };
+	entt::registry* m_registry = nullptr;
 };
   
 } // namespace medicimage
@@ -0,0 +1,246 @@
+#include "drawing/history.h"
+#include "drawing/components.h"
+#include "drawing/registry_archive.h"
+#include "core/log.h"
+
+#include <algorithm>
+
+namespace medicimage
+{
+
+// the slices and splines of a skin template are separate entities, they are recorded with their template
+template<typename Func>
+static void ForEachChild(entt::registry& registry, entt::entity entity, Func&& func)
+{
+  if(!registry.valid(entity) || !registry.all_of<SkinTemplateComponent>(entity))
+    return;
+  const auto& skinTemplate = registry.get<SkinTemplateComponent>(entity);
+  for(const auto* children : {&skinTemplate.leftHorizontalSlices, &skinTemplate.rightHorizontalSlices, &skinTemplate.verticalSlices, &skinTemplate.splines})
+  {
+    for(auto child : *children)
+      func(child);
+  }
+}
+
+void History::Clear()
+{
+  m_steps.clear();
+  m_cursor = 0;
+  m_pending.clear();
+  m_open = false;
+  m_recordedSteps = 0;
+  m_base = SaveState();
+  m_bytes = m_base.size();
+}
+
+std::vector<char> History::SaveState() const
+{
+  OutputArchive archive;
+  SaveSnapshot(*m_registry, archive);
+  std::vector<entt::entity> drawOrder;
+  m_drawList->GetOrder(drawOrder);
+  archive.Write(drawOrder);
+  return std::move(archive.GetBuffer());
+}
+
+bool History::LoadState(std::span<const char> state)
+{
+  InputArchive archive(state);
+  if(!LoadSnapshot(*m_registry, archive))
+    return false;
+  // the loaded shapes are appended in storage order, they are put back in the saved order
+  std::vector<entt::entity> drawOrder;
+  archive.Read(drawOrder);
+  std::vector<DrawList::Placement> placements;
+  for(auto e : drawOrder)
+  {
+    if(m_registry->valid(e))
+      placements.push_back({e, placements.size()});
+  }
+  m_drawList->Place(placements);
+  return true;
+}
+
+void History::Begin()
+{
+  // the positions are taken from the order before the step, the entities removed by it could shift each other
+  if(!m_open)
+    m_drawList->GetOrder(m_drawOrder);
+  m_open = true;
+}
+
+size_t History::GetPosition(entt::entity entity) const
+{
+  auto it = std::find(m_drawOrder.begin(), m_drawOrder.end(), entity);
+  return it != m_drawOrder.end() ? static_cast<size_t>(std::distance(m_drawOrder.begin(), it)) : s_noPosition;
+}
+
+bool History::IsTracked(entt::entity entity) const
+{
+  return std::any_of(m_pending.begin(), m_pending.end(), [entity](const Delta& delta) { return delta.entity == entity; });
+}
+
+void History::TrackChildren(entt::entity entity, bool created)
+{
+  ForEachChild(*m_registry, entity, [this, created](entt::entity child) {
+    if(!IsTracked(child))
+      m_pending.push_back(Delta{child, created ? std::vector<char>{} : SaveEntityState(*m_registry, child), {}, GetPosition(child)});
+  });
+}
+
+void History::Track(entt::entity entity)
+{
+  assert(m_open && "Tracking an entity without an open step");
+  // only the first state counts, the step goes from the state before its first modification
+  if(IsTracked(entity))
+    return;
+  m_pending.push_back(Delta{entity, SaveEntityState(*m_registry, entity), {}, GetPosition(entity)});
+  TrackChildren(entity, false);
+}
+
+void History::TrackCreated(entt::entity entity)
+{
+  assert(m_open && "Tracking an entity without an open step");
+  if(IsTracked(entity))
+    return;
+  m_pending.push_back(Delta{entity, {}, {}});
+  TrackChildren(entity, true);
+}
+
+void History::Commit()
+{
+  if(!m_open)
+    return;
+  m_open = false;
+
+  // the children created during the step (e.g. the slices of a resized skin template) did not exist before it
+  for(size_t i = 0; i < m_pending.size(); i++)
+  {
+    ForEachChild(*m_registry, m_pending[i].entity, [this](entt::entity child) {
+      if(!IsTracked(child))
+        m_pending.push_back(Delta{child, {}, {}});
+    });
+  }
+
+  Step step;
+  m_drawList->GetOrder(m_drawOrder);
+  for(auto& delta : m_pending)
+  {
+    delta.after = SaveEntityState(*m_registry, delta.entity);
+    delta.afterPosition = GetPosition(delta.entity);
+    // a step of BringToFront/SendToBack changes only the position
+    if(delta.before == delta.after && delta.beforePosition == delta.afterPosition)
+      continue;
+    step.bytes += sizeof(Delta) + delta.before.size() + delta.after.size();
+    step.deltas.push_back(std::move(delta));
+  }
+  m_pending.clear();
+  if(step.deltas.empty())
+    return;
+
+  // a new edit drops the redo branch
+  DropRedoSteps();
+  if(++m_recordedSteps % s_snapshotInterval == 0)
+  {
+    step.snapshot = SaveState();
+    step.bytes += step.snapshot.size();
+  }
+  m_bytes += step.bytes;
+  m_steps.push_back(std::move(step));
+  m_cursor = m_steps.size();
+  Compact();
+}
+
+bool History::Undo()
+{
+  Commit();
+  if(!CanUndo())
+    return false;
+  const Step& step = m_steps[--m_cursor];
+  if(step.compacted)
+    return LoadState(m_base);
+  // the deltas are applied in reverse, so the entities are destroyed and recreated in the opposite order
+  for(auto it = step.deltas.rbegin(); it != step.deltas.rend(); ++it)
+    LoadEntityState(*m_registry, it->entity, it->before);
+  RestorePositions(step, true);
+  return true;
+}
+
+bool History::Redo()
+{
+  Commit();
+  if(!CanRedo())
+    return false;
+  const Step& step = m_steps[m_cursor++];
+  if(step.compacted)
+    return LoadState(step.snapshot);
+  for(const auto& delta : step.deltas)
+    LoadEntityState(*m_registry, delta.entity, delta.after);
+  RestorePositions(step, false);
+  return true;
+}
+
+void History::RestorePositions(const Step& step, bool undo)
+{
+  // the recreated entities are appended on top by the draw list and the reordered ones are where the step left them,
+  // every entity of the step is put back to its recorded position, the others keep their relative order
+  std::vector<DrawList::Placement> placements;
+  for(const auto& delta : step.deltas)
+  {
+    const size_t position = undo ? delta.beforePosition : delta.afterPosition;
+    if(position != s_noPosition && m_registry->valid(delta.entity))
+      placements.push_back({delta.entity, position});
+  }
+  if(placements.empty())
+    return;
+  std::sort(placements.begin(), placements.end(), [](const auto& a, const auto& b) { return a.position < b.position; });
+  m_drawList->Place(placements);
+}
+
+void History::DropRedoSteps()
+{
+  while(m_steps.size() > m_cursor)
+  {
+    m_bytes -= m_steps.back().bytes;
+    m_steps.pop_back();
+  }
+}
+
+void History::Compact()
+{
+  // over the budget the oldest steps are folded into a single one up to the next snapshot, undoing it loads the base;
+  // when there is nothing left to fold, the oldest step is forgotten and its snapshot becomes the base
+  while(m_bytes > s_memoryBudget)
+  {
+    auto applied = m_steps.begin() + m_cursor;
+    auto next = std::find_if(m_steps.begin() + std::min<size_t>(1, m_cursor), applied, [](const Step& step) { return !step.snapshot.empty(); });
+    if(next != applied)
+    {
+      Step folded;
+      folded.compacted = true;
+      folded.snapshot = std::move(next->snapshot);
+      folded.bytes = folded.snapshot.size();
+      const size_t count = std::distance(m_steps.begin(), next) + 1;
+      for(auto it = m_steps.begin(); it != m_steps.begin() + count; ++it)
+        m_bytes -= it->bytes;
+      m_steps.erase(m_steps.begin(), m_steps.begin() + count);
+      m_steps.push_front(std::move(folded));
+      m_bytes += m_steps.front().bytes;
+      m_cursor -= count - 1;
+    }
+    else if(m_cursor != 0 && !m_steps.front().snapshot.empty())
+    {
+      m_bytes -= m_base.size() + m_steps.front().bytes - m_steps.front().snapshot.size();
+      m_base = std::move(m_steps.front().snapshot);
+      m_steps.pop_front();
+      m_cursor--;
+    }
+    else
+    {
+      APP_CORE_WARN("Undo history is over its memory budget: {} bytes", m_bytes);
+      break;
+    }
+  }
+}
+
+} // namespace medicimage
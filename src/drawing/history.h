@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <vector>
+#include <entt/entt.hpp>
+
+#include "drawing/draw_list.h"
+
+namespace medicimage
+{
+
+/// @brief Undo/redo stack of a drawing sheet, every step holds the before and after states of the entities it touched
+class History
+{
+public:
+  History(entt::registry& registry, DrawList& drawList) : m_registry(&registry), m_drawList(&drawList) {}
+
+  // forgets every step, the current state of the registry becomes the base of the history
+  void Clear();
+
+  // a step is recorded between Begin and Commit, nested calls are merged, so a whole drag becomes one step
+  void Begin();
+  void Track(entt::entity entity);         // before the entity is modified or destroyed
+  void TrackCreated(entt::entity entity);  // after the entity is created
+  void Commit();
+  bool IsOpen() const { return m_open; }
+
+  bool CanUndo() const { return m_cursor != 0; }
+  bool CanRedo() const { return m_cursor != m_steps.size(); }
+  bool Undo();
+  bool Redo();
+
+  size_t GetMemoryUsage() const { return m_bytes; }
+private:
+  struct Delta
+  {
+    entt::entity entity;
+    std::vector<char> before; // empty, when the entity did not exist
+    std::vector<char> after;
+    // the positions in the draw list, a recreated entity is put back where it was instead of on top
+    size_t beforePosition = s_noPosition;
+    size_t afterPosition = s_noPosition;
+  };
+  struct Step
+  {
+    std::vector<Delta> deltas;
+    std::vector<char> snapshot; // the whole sheet after the step, taken only on every s_snapshotInterval-th step
+    bool compacted = false;     // the deltas are dropped, the step goes between the base and its snapshot
+    size_t bytes = 0;
+  };
+
+  // the registry snapshot followed by the draw order, the snapshot alone is in storage order
+  std::vector<char> SaveState() const;
+  bool LoadState(std::span<const char> state);
+  bool IsTracked(entt::entity entity) const;
+  size_t GetPosition(entt::entity entity) const;
+  void RestorePositions(const Step& step, bool undo);
+  void TrackChildren(entt::entity entity, bool created);
+  void DropRedoSteps();
+  void Compact();
+
+  entt::registry* m_registry;
+  DrawList* m_drawList;
+  std::vector<entt::entity> m_drawOrder; // the draw order at the beginning of the open step, then at its end
+  std::deque<Step> m_steps;
+  size_t m_cursor = 0;          // the number of applied steps, the rest can be redone
+  std::vector<char> m_base;     // state of the sheet before the first step
+  std::vector<Delta> m_pending; // the deltas of the open step, with only the before states
+  bool m_open = false;
+  size_t m_recordedSteps = 0;
+  size_t m_bytes = 0;
+
+  static constexpr size_t s_noPosition = static_cast<size_t>(-1);
+  static constexpr size_t s_snapshotInterval = 64;
+  static constexpr size_t s_memoryBudget = 16 * 1024 * 1024;
+};
+
+} // namespace medicimage
@@ -0,0 +1,116 @@
+#include "drawing/hit_testing.h"
+#include "drawing/components.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace medicimage
+{
+
+bool HitTesting::IsUnderPoint(Entity entity, glm::vec2 pos)
+{
+  const auto& contour = entity.GetComponent<BoundingContourComponent>();
+  if(contour.pointCount == 0)
+    return false;
+  const glm::vec2 translation = entity.GetComponent<TransformComponent>().translation;
+  if(!AabbContains(contour.min + translation, contour.max + translation, pos))
+    return false;
+
+  if(entity.HasComponent<CircleComponent>())
+  {
+    const auto& circle = entity.GetComponent<CircleComponent>();
+    return EllipseContains(translation, glm::vec2{circle.radius, circle.radius * circle.aspectRatio}, pos);
+  }
+  if(entity.HasComponent<LineComponent>())
+  {
+    const auto& line = entity.GetComponent<LineComponent>();
+    return SegmentDistance(line.begin + translation, line.end + translation, pos) <= s_lineHitDistance;
+  }
+  if(entity.HasComponent<ArrowComponent>())
+  {
+    const auto& arrow = entity.GetComponent<ArrowComponent>();
+    return SegmentDistance(arrow.begin + translation, arrow.end + translation, pos) <= s_lineHitDistance;
+  }
+  if(entity.HasComponent<PolylineComponent>())
+    return PolylineDistance(entity.GetComponent<PolylineComponent>().points, translation, pos) <= s_lineHitDistance;
+  // rectangles, text boxes and skin templates fill their bounding box
+  if(entity.HasComponent<RectangleComponent>() || entity.HasComponent<TextComponent>() || entity.HasComponent<SkinTemplateComponent>())
+    return true;
+  return PolygonContains(contour.GetPoints(), translation, pos);
+}
+
+bool HitTesting::IsInsideArea(Entity entity, glm::vec2 areaMin, glm::vec2 areaMax)
+{
+  // the contours are convex and the area is axis aligned, so the contour is inside when its bounds are
+  const auto& contour = entity.GetComponent<BoundingContourComponent>();
+  if(contour.pointCount == 0)
+    return false;
+  const glm::vec2 translation = entity.GetComponent<TransformComponent>().translation;
+  return AabbContains(areaMin, areaMax, contour.min + translation) && AabbContains(areaMin, areaMax, contour.max + translation);
+}
+
+int HitTesting::GetPickPointAt(Entity entity, glm::vec2 pos, float boxSize)
+{
+  const auto& pickPoints = entity.GetComponent<PickPointsComponent>().pickPoints;
+  const glm::vec2 translation = entity.GetComponent<TransformComponent>().translation;
+  const glm::vec2 halfBox{boxSize / 2, boxSize / 2};
+  for(int i = 0; i < static_cast<int>(pickPoints.size()); i++)
+  {
+    const glm::vec2 point = pickPoints[i] + translation;
+    if(AabbContains(point - halfBox, point + halfBox, pos))
+      return i;
+  }
+  return -1;
+}
+
+bool HitTesting::AabbContains(glm::vec2 min, glm::vec2 max, glm::vec2 pos)
+{
+  return pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y;
+}
+
+bool HitTesting::EllipseContains(glm::vec2 center, glm::vec2 radii, glm::vec2 pos)
+{
+  if(radii.x <= 0.0f || radii.y <= 0.0f)
+    return false;
+  const glm::vec2 d = (pos - center) / radii;
+  return glm::dot(d, d) <= 1.0f;
+}
+
+float HitTesting::SegmentDistance(glm::vec2 begin, glm::vec2 end, glm::vec2 pos)
+{
+  const glm::vec2 segment = end - begin;
+  const float lengthSquared = glm::dot(segment, segment);
+  if(lengthSquared == 0.0f)
+    return glm::length(pos - begin);
+  const float t = glm::clamp(glm::dot(pos - begin, segment) / lengthSquared, 0.0f, 1.0f);
+  return glm::length(pos - (begin + t * segment));
+}
+
+float HitTesting::PolylineDistance(std::span<const glm::vec2> points, glm::vec2 translation, glm::vec2 pos)
+{
+  // the distance to the closest segment, the points are relative to the translation
+  const glm::vec2 p = pos - translation;
+  if(points.size() == 1)
+    return glm::length(p - points[0]);
+  float distance = std::numeric_limits<float>::max();
+  for(size_t i = 1; i < points.size(); i++)
+    distance = std::min(distance, SegmentDistance(points[i - 1], points[i], p));
+  return distance;
+}
+
+bool HitTesting::PolygonContains(std::span<const glm::vec2> contour, glm::vec2 translation, glm::vec2 pos)
+{
+  // even-odd crossing test, the contour is relative to the translation
+  const glm::vec2 p = pos - translation;
+  bool inside = false;
+  for(size_t i = 0, j = contour.size() - 1; i < contour.size(); j = i++)
+  {
+    const glm::vec2& a = contour[i];
+    const glm::vec2& b = contour[j];
+    if((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+      inside = !inside;
+  }
+  return inside;
+}
+
+} // namespace medicimage
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "drawing/entity.h"
+
+#include <glm/glm.hpp>
+#include <span>
+
+namespace medicimage
+{
+
+/// @brief Analytic hit tests per shape type, every test starts with a bounding box reject and none of them allocates
+class HitTesting
+{
+public:
+  // positions are normalized sheet coordinates, the entity's translation is applied here
+  static bool IsUnderPoint(Entity entity, glm::vec2 pos);
+  // the entity has to be entirely inside the area
+  static bool IsInsideArea(Entity entity, glm::vec2 areaMin, glm::vec2 areaMax);
+  // returns the index of the pickpoint whose box contains the position, -1 if there is none
+  static int GetPickPointAt(Entity entity, glm::vec2 pos, float boxSize);
+
+  static bool AabbContains(glm::vec2 min, glm::vec2 max, glm::vec2 pos);
+  static bool EllipseContains(glm::vec2 center, glm::vec2 radii, glm::vec2 pos);
+  static float SegmentDistance(glm::vec2 begin, glm::vec2 end, glm::vec2 pos);
+  static float PolylineDistance(std::span<const glm::vec2> points, glm::vec2 translation, glm::vec2 pos);
+  static bool PolygonContains(std::span<const glm::vec2> contour, glm::vec2 translation, glm::vec2 pos);
+private:
+  static constexpr float s_lineHitDistance = 0.01f; // same as the offset of the line's and polyline's bounding contour
+};
+
+} // namespace medicimage
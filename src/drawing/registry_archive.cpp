@@ -0,0 +1,233 @@
+#include "drawing/registry_archive.h"
+#include "core/log.h"
+
+namespace medicimage
+{
+
+void OutputArchive::Write(const std::string& value)
+{
+  Write(static_cast<std::uint32_t>(value.size()));
+  m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+}
+
+void OutputArchive::Write(const TagComponent& component)
+{
+  Write(component.tag);
+}
+
+void OutputArchive::Write(const CommonAttributesComponent& component)
+{
+  Write(component.temporary);
+  Write(component.filled);
+  Write(component.composed);
+}
+
+void OutputArchive::Write(const PickPointsComponent& component)
+{
+  Write(component.pickPoints);
+}
+
+void OutputArchive::Write(const SkinTemplateComponent& component)
+{
+  Write(component.boundingRectSize);
+  Write(component.leftHorSliceCount);
+  Write(component.rightHorSliceCount);
+  Write(component.vertSliceCount);
+  Write(component.vertSliceWidthSpan);
+  Write(component.leftHorSliceWidthSpan);
+  Write(component.leftHorSliceHeightSpan);
+  Write(component.rightHorSliceWidthSpan);
+  Write(component.rightHorSliceHeightSpan);
+  Write(component.leftHorizontalSlices);
+  Write(component.rightHorizontalSlices);
+  Write(component.verticalSlices);
+  Write(component.splines);
+  Write(component.drawable);
+  Write(component.drawSpline);
+}
+
+void OutputArchive::Write(const TextComponent& component)
+{
+  Write(component.text);
+  Write(component.fontSize);
+  Write(component.boxSize);
+}
+
+void OutputArchive::Write(const PolylineComponent& component)
+{
+  Write(component.points);
+}
+
+void InputArchive::Read(std::string& value)
+{
+  std::uint32_t size = 0;
+  Read(size);
+  if(m_failed || m_offset + size > m_buffer.size())
+  {
+    m_failed = true;
+    value.clear();
+    return;
+  }
+  value.assign(m_buffer.data() + m_offset, size);
+  m_offset += size;
+}
+
+void InputArchive::Read(TagComponent& component)
+{
+  Read(component.tag);
+}
+
+void InputArchive::Read(CommonAttributesComponent& component)
+{
+  Read(component.temporary);
+  Read(component.filled);
+  Read(component.composed);
+}
+
+void InputArchive::Read(PickPointsComponent& component)
+{
+  Read(component.pickPoints);
+}
+
+void InputArchive::Read(SkinTemplateComponent& component)
+{
+  Read(component.boundingRectSize);
+  Read(component.leftHorSliceCount);
+  Read(component.rightHorSliceCount);
+  Read(component.vertSliceCount);
+  Read(component.vertSliceWidthSpan);
+  Read(component.leftHorSliceWidthSpan);
+  Read(component.leftHorSliceHeightSpan);
+  Read(component.rightHorSliceWidthSpan);
+  Read(component.rightHorSliceHeightSpan);
+  Read(component.leftHorizontalSlices);
+  Read(component.rightHorizontalSlices);
+  Read(component.verticalSlices);
+  Read(component.splines);
+  Read(component.drawable);
+  Read(component.drawSpline);
+}
+
+void InputArchive::Read(TextComponent& component)
+{
+  Read(component.text);
+  Read(component.fontSize);
+  Read(component.boxSize);
+}
+
+void InputArchive::Read(PolylineComponent& component)
+{
+  Read(component.points);
+}
+
+template<typename... Components>
+static void SaveComponents(entt::registry& registry, OutputArchive& archive, entt::type_list<Components...>)
+{
+  entt::snapshot{registry}.entities(archive).template component<Components...>(archive);
+}
+
+template<typename... Components>
+static void LoadComponents(entt::registry& registry, InputArchive& archive, entt::type_list<Components...>)
+{
+  entt::snapshot_loader{registry}.entities(archive).template component<Components...>(archive).orphans();
+}
+
+std::vector<char> SaveSnapshot(entt::registry& registry)
+{
+  OutputArchive archive;
+  SaveSnapshot(registry, archive);
+  return std::move(archive.GetBuffer());
+}
+
+bool LoadSnapshot(entt::registry& registry, std::span<const char> snapshot)
+{
+  InputArchive archive(snapshot);
+  return LoadSnapshot(registry, archive);
+}
+
+void SaveSnapshot(entt::registry& registry, OutputArchive& archive)
+{
+  SaveComponents(registry, archive, SheetComponents{});
+}
+
+bool LoadSnapshot(entt::registry& registry, InputArchive& archive)
+{
+  // the loader restores the handles as they were, it needs a registry without alive entities;
+  // clearing fires the destroy signals, so the draw list and the spatial index drop everything too
+  registry.clear();
+  LoadComponents(registry, archive, SheetComponents{});
+  if(archive.Failed())
+  {
+    APP_CORE_ERR("Corrupted registry snapshot, the sheet is left empty");
+    registry.clear();
+    return false;
+  }
+  return true;
+}
+
+template<typename... Components>
+static void SaveComponents(entt::registry& registry, entt::entity entity, OutputArchive& archive, entt::type_list<Components...>)
+{
+  // a mask of the present components, followed by them in the list order
+  std::uint32_t mask = 0;
+  std::uint32_t bit = 1;
+  ((mask |= registry.all_of<Components>(entity) ? bit : 0u, bit <<= 1), ...);
+  archive.Write(mask);
+  ((registry.all_of<Components>(entity) ? archive.Write(registry.get<Components>(entity)) : void()), ...);
+}
+
+template<typename Component>
+static void LoadComponent(entt::registry& registry, entt::entity entity, InputArchive& archive, bool present)
+{
+  if(!present)
+  {
+    registry.remove<Component>(entity);
+    return;
+  }
+  Component component;
+  archive.Read(component);
+  // replacing fires on_update, the draw list and the spatial index follow the restored state
+  registry.emplace_or_replace<Component>(entity, std::move(component));
+}
+
+template<typename... Components>
+static void LoadComponents(entt::registry& registry, entt::entity entity, InputArchive& archive, entt::type_list<Components...>)
+{
+  std::uint32_t mask = 0;
+  archive.Read(mask);
+  std::uint32_t bit = 1;
+  ((LoadComponent<Components>(registry, entity, archive, (mask & bit) != 0), bit <<= 1), ...);
+}
+
+std::vector<char> SaveEntityState(entt::registry& registry, entt::entity entity)
+{
+  if(!registry.valid(entity))
+    return {};
+  OutputArchive archive;
+  SaveComponents(registry, entity, archive, SheetComponents{});
+  return std::move(archive.GetBuffer());
+}
+
+void LoadEntityState(entt::registry& registry, entt::entity entity, std::span<const char> state)
+{
+  if(state.empty())
+  {
+    if(registry.valid(entity))
+      registry.destroy(entity);
+    return;
+  }
+  if(!registry.valid(entity))
+  {
+    // the handle is referenced by other components (e.g. the skin template slices), it has to be the same
+    if(const auto created = registry.create(entity); created != entity)
+    {
+      APP_CORE_ERR("Entity handle:{} is taken, cannot restore it", entt::to_integral(entity));
+      registry.destroy(created);
+      return;
+    }
+  }
+  InputArchive archive(state);
+  LoadComponents(registry, entity, archive, SheetComponents{});
+}
+
+} // namespace medicimage
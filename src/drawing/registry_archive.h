@@ -0,0 +1,148 @@
+#pragma once
+
+#include "drawing/components.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <entt/entt.hpp>
+
+namespace medicimage
+{
+
+// every component a drawing sheet is made of, in restore order: the draw list needs the common attributes
+// when a shape is constructed and the spatial index needs the transform and the pickpoints with the contour
+using SheetComponents = entt::type_list<IDComponent, TagComponent, TransformComponent, CommonAttributesComponent,
+  ColorComponent, ThicknessComponent, PickPointsComponent, BoundingContourComponent, CircleComponent, RectangleComponent,
+  ArrowComponent, LineComponent, SplineComponent, SkinTemplateComponent, TextComponent, PolylineComponent>;
+
+/// @brief Binary archive for the EnTT snapshots and the per entity states of the undo history
+// the selection is not archived, it is a state of the editing and not of the annotation
+class OutputArchive
+{
+public:
+  // EnTT snapshot interface
+  void operator()(std::underlying_type_t<entt::entity> value) { Write(value); }
+  void operator()(entt::entity entity) { Write(entt::to_integral(entity)); }
+  template<typename Component>
+  void operator()(entt::entity entity, const Component& component)
+  {
+    (*this)(entity);
+    Write(component);
+  }
+
+  template<typename T> requires std::is_trivially_copyable_v<T>
+  void Write(const T& value)
+  {
+    const auto offset = m_buffer.size();
+    m_buffer.resize(offset + sizeof(T));
+    std::memcpy(m_buffer.data() + offset, &value, sizeof(T));
+  }
+  template<typename T>
+  void Write(const std::vector<T>& values)
+  {
+    Write(static_cast<std::uint32_t>(values.size()));
+    for(const auto& value : values)
+      Write(value);
+  }
+  void Write(const std::string& value);
+  void Write(const TagComponent& component);
+  void Write(const CommonAttributesComponent& component);
+  void Write(const PickPointsComponent& component);
+  void Write(const SkinTemplateComponent& component);
+  void Write(const TextComponent& component);
+  void Write(const PolylineComponent& component);
+
+  std::vector<char>& GetBuffer() { return m_buffer; }
+private:
+  std::vector<char> m_buffer;
+};
+
+class InputArchive
+{
+public:
+  InputArchive(std::span<const char> buffer) : m_buffer(buffer) {}
+
+  // EnTT snapshot loader interface, the plain values are the entity and component counts; every counted item
+  // is at least an entity handle, so a count which does not fit into the rest of the archive is a corrupted one
+  void operator()(std::underlying_type_t<entt::entity>& value)
+  {
+    Read(value);
+    if(!CanFit(value, sizeof(value)))
+      value = 0;
+  }
+  void operator()(entt::entity& entity)
+  {
+    std::underlying_type_t<entt::entity> value{};
+    Read(value);
+    entity = entt::entity{value};
+  }
+  template<typename Component>
+  void operator()(entt::entity& entity, Component& component)
+  {
+    (*this)(entity);
+    Read(component);
+  }
+
+  template<typename T> requires std::is_trivially_copyable_v<T>
+  void Read(T& value)
+  {
+    if(m_offset + sizeof(T) > m_buffer.size())
+    { // a truncated archive reads as zeroes, the callers validate the result
+      m_failed = true;
+      value = T{};
+      return;
+    }
+    std::memcpy(&value, m_buffer.data() + m_offset, sizeof(T));
+    m_offset += sizeof(T);
+  }
+  template<typename T>
+  void Read(std::vector<T>& values)
+  {
+    std::uint32_t size = 0;
+    Read(size);
+    constexpr size_t itemSize = std::is_trivially_copyable_v<T> ? sizeof(T) : 1;
+    values.resize(CanFit(size, itemSize) ? size : 0);
+    for(auto& value : values)
+      Read(value);
+  }
+  void Read(std::string& value);
+  void Read(TagComponent& component);
+  void Read(CommonAttributesComponent& component);
+  void Read(PickPointsComponent& component);
+  void Read(SkinTemplateComponent& component);
+  void Read(TextComponent& component);
+  void Read(PolylineComponent& component);
+
+  bool Failed() const { return m_failed; }
+  bool AtEnd() const { return m_offset == m_buffer.size(); }
+private:
+  // the counts are checked before anything is allocated or created for them
+  bool CanFit(std::uint64_t count, size_t itemSize)
+  {
+    if(!m_failed && count <= (m_buffer.size() - m_offset) / itemSize)
+      return true;
+    m_failed = true;
+    return false;
+  }
+
+  std::span<const char> m_buffer;
+  size_t m_offset = 0;
+  bool m_failed = false;
+};
+
+// whole registry snapshots, the entity handles are kept, so the handles stored in the components stay valid
+std::vector<char> SaveSnapshot(entt::registry& registry);
+bool LoadSnapshot(entt::registry& registry, std::span<const char> snapshot);
+void SaveSnapshot(entt::registry& registry, OutputArchive& archive);
+bool LoadSnapshot(entt::registry& registry, InputArchive& archive);
+
+// the components of a single entity, an empty state means the entity does not exist
+std::vector<char> SaveEntityState(entt::registry& registry, entt::entity entity);
+void LoadEntityState(entt::registry& registry, entt::entity entity, std::span<const char> state);
+
+} // namespace medicimage
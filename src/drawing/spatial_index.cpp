@@ -0,0 +1,205 @@
+#include "drawing/spatial_index.h"
+#include "drawing/components.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MI_SPATIAL_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace medicimage
+{
+
+SpatialIndex::~SpatialIndex()
+{
+  Disconnect();
+}
+
+void SpatialIndex::Connect(entt::registry& registry)
+{
+  Disconnect();
+  m_registry = &registry;
+  registry.on_construct<BoundingContourComponent>().connect<&SpatialIndex::OnEntityChanged>(this);
+  registry.on_update<BoundingContourComponent>().connect<&SpatialIndex::OnEntityChanged>(this);
+  registry.on_update<TransformComponent>().connect<&SpatialIndex::OnEntityChanged>(this);
+  registry.on_destroy<BoundingContourComponent>().connect<&SpatialIndex::OnEntityRemoved>(this);
+
+  // entities created before the connection
+  for(auto e : registry.view<BoundingContourComponent, TransformComponent>())
+    OnEntityChanged(registry, e);
+}
+
+void SpatialIndex::Disconnect()
+{
+  if(m_registry == nullptr)
+    return;
+  m_registry->on_construct<BoundingContourComponent>().disconnect(this);
+  m_registry->on_update<BoundingContourComponent>().disconnect(this);
+  m_registry->on_update<TransformComponent>().disconnect(this);
+  m_registry->on_destroy<BoundingContourComponent>().disconnect(this);
+  m_registry = nullptr;
+  for(auto& cell : m_cells)
+    cell.clear();
+  m_boxes.clear();
+  m_contours = ContourBounds();
+  m_contourSlots.clear();
+}
+
+void SpatialIndex::OnEntityChanged(entt::registry& registry, entt::entity entity)
+{
+  Remove(entity);
+  if(!registry.all_of<BoundingContourComponent, TransformComponent>(entity))
+    return;
+  const auto& contour = registry.get<BoundingContourComponent>(entity);
+  if(contour.pointCount == 0)
+    return;
+
+  const glm::vec2 translation = registry.get<TransformComponent>(entity).translation;
+  const Box contourBox{contour.min + translation, contour.max + translation};
+  Box box{contour.min, contour.max};
+  // pickpoints can be dragged out of the contour (e.g. the begin of a line), the box has to cover them too
+  if(auto* pickPoints = registry.try_get<PickPointsComponent>(entity))
+  {
+    for(const auto& point : pickPoints->pickPoints)
+    {
+      box.min = glm::min(box.min, point);
+      box.max = glm::max(box.max, point);
+    }
+  }
+  box.min += translation;
+  box.max += translation;
+  Insert(entity, box, contourBox);
+}
+
+void SpatialIndex::OnEntityRemoved(entt::registry& registry, entt::entity entity)
+{
+  Remove(entity);
+}
+
+void SpatialIndex::Insert(entt::entity entity, const Box& box, const Box& contour)
+{
+  m_boxes[entity] = box;
+  m_contourSlots[entity] = m_contours.entities.size();
+  m_contours.minX.push_back(contour.min.x);
+  m_contours.minY.push_back(contour.min.y);
+  m_contours.maxX.push_back(contour.max.x);
+  m_contours.maxY.push_back(contour.max.y);
+  m_contours.entities.push_back(entity);
+  const auto minCell = GetCell(box.min);
+  const auto maxCell = GetCell(box.max);
+  for(int y = minCell.y; y <= maxCell.y; y++)
+    for(int x = minCell.x; x <= maxCell.x; x++)
+      m_cells[y * s_gridSize + x].push_back(entity);
+}
+
+void SpatialIndex::Remove(entt::entity entity)
+{
+  auto it = m_boxes.find(entity);
+  if(it == m_boxes.end())
+    return;
+  const auto minCell = GetCell(it->second.min);
+  const auto maxCell = GetCell(it->second.max);
+  for(int y = minCell.y; y <= maxCell.y; y++)
+  {
+    for(int x = minCell.x; x <= maxCell.x; x++)
+    {
+      auto& cell = m_cells[y * s_gridSize + x];
+      cell.erase(std::remove(cell.begin(), cell.end(), entity), cell.end());
+    }
+  }
+  m_boxes.erase(it);
+
+  // the last slot is moved into the removed one, the order of the bounds does not matter
+  auto slotIt = m_contourSlots.find(entity);
+  const size_t slot = slotIt->second;
+  const size_t last = m_contours.entities.size() - 1;
+  m_contours.minX[slot] = m_contours.minX[last];
+  m_contours.minY[slot] = m_contours.minY[last];
+  m_contours.maxX[slot] = m_contours.maxX[last];
+  m_contours.maxY[slot] = m_contours.maxY[last];
+  m_contours.entities[slot] = m_contours.entities[last];
+  m_contourSlots[m_contours.entities[slot]] = slot;
+  m_contours.minX.pop_back();
+  m_contours.minY.pop_back();
+  m_contours.maxX.pop_back();
+  m_contours.maxY.pop_back();
+  m_contours.entities.pop_back();
+  m_contourSlots.erase(slotIt);
+}
+
+glm::ivec2 SpatialIndex::GetCell(glm::vec2 pos)
+{
+  glm::ivec2 cell = glm::ivec2(glm::floor(pos * static_cast<float>(s_gridSize)));
+  return glm::clamp(cell, glm::ivec2(0), glm::ivec2(s_gridSize - 1));
+}
+
+bool SpatialIndex::Overlaps(const Box& a, const Box& b)
+{
+  return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+std::vector<entt::entity> SpatialIndex::QueryPoint(glm::vec2 pos, float margin) const
+{
+  return Query(Box{pos - glm::vec2(margin), pos + glm::vec2(margin)});
+}
+
+std::vector<entt::entity> SpatialIndex::QueryArea(glm::vec2 first, glm::vec2 second) const
+{
+  return Query(Box{glm::min(first, second), glm::max(first, second)});
+}
+
+std::vector<entt::entity> SpatialIndex::QueryContained(glm::vec2 first, glm::vec2 second) const
+{
+  const glm::vec2 areaMin = glm::min(first, second);
+  const glm::vec2 areaMax = glm::max(first, second);
+  std::vector<entt::entity> contained;
+  const size_t count = m_contours.entities.size();
+  size_t i = 0;
+#ifdef MI_SPATIAL_INDEX_SSE2
+  const __m128 minX = _mm_set1_ps(areaMin.x);
+  const __m128 minY = _mm_set1_ps(areaMin.y);
+  const __m128 maxX = _mm_set1_ps(areaMax.x);
+  const __m128 maxY = _mm_set1_ps(areaMax.y);
+  for(; i + 4 <= count; i += 4)
+  {
+    __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&m_contours.minX[i]), minX), _mm_cmpge_ps(_mm_loadu_ps(&m_contours.minY[i]), minY));
+    inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_loadu_ps(&m_contours.maxX[i]), maxX));
+    inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_loadu_ps(&m_contours.maxY[i]), maxY));
+    for(unsigned int mask = static_cast<unsigned int>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1)
+      contained.push_back(m_contours.entities[i + std::countr_zero(mask)]);
+  }
+#endif
+  // the remainder, or every entity without SSE2
+  for(; i < count; i++)
+  {
+    if(m_contours.minX[i] >= areaMin.x && m_contours.minY[i] >= areaMin.y && m_contours.maxX[i] <= areaMax.x && m_contours.maxY[i] <= areaMax.y)
+      contained.push_back(m_contours.entities[i]);
+  }
+  return contained;
+}
+
+std::vector<entt::entity> SpatialIndex::Query(const Box& area) const
+{
+  std::vector<entt::entity> candidates;
+  const auto minCell = GetCell(area.min);
+  const auto maxCell = GetCell(area.max);
+  for(int y = minCell.y; y <= maxCell.y; y++)
+  {
+    for(int x = minCell.x; x <= maxCell.x; x++)
+    {
+      for(auto e : m_cells[y * s_gridSize + x])
+      {
+        if(Overlaps(m_boxes.at(e), area))
+          candidates.push_back(e);
+      }
+    }
+  }
+  // an entity spanning several cells shows up once per cell
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  return candidates;
+}
+
+} // namespace medicimage
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace medicimage
+{
+
+/// @brief Uniform grid over the translated bounding boxes of the drawn entities, it is only a broad phase:
+///         the queries return the entities whose box can contain the point/area, the exact contour test is up to the caller
+class SpatialIndex
+{
+public:
+  SpatialIndex() = default;
+  SpatialIndex(const SpatialIndex&) = delete;
+  SpatialIndex& operator=(const SpatialIndex&) = delete;
+  ~SpatialIndex();
+
+  // keeps the index in sync through the registry signals of the transform and the bounding contour
+  void Connect(entt::registry& registry);
+  void Disconnect();
+
+  // the candidates are in no particular order, the z order is kept by the draw list
+  std::vector<entt::entity> QueryPoint(glm::vec2 pos, float margin = 0.0f) const;
+  std::vector<entt::entity> QueryArea(glm::vec2 first, glm::vec2 second) const;
+  // the entities whose contour bounds are inside the area, the box select tests every entity in one batch
+  std::vector<entt::entity> QueryContained(glm::vec2 first, glm::vec2 second) const;
+  size_t GetEntityCount() const {return m_boxes.size();}
+private:
+  struct Box
+  {
+    glm::vec2 min;
+    glm::vec2 max;
+  };
+  // the translated contour bounds in structure of arrays layout, so four of them are compared at once
+  struct ContourBounds
+  {
+    std::vector<float> minX, minY, maxX, maxY;
+    std::vector<entt::entity> entities;
+  };
+  void OnEntityChanged(entt::registry& registry, entt::entity entity);
+  void OnEntityRemoved(entt::registry& registry, entt::entity entity);
+  void Insert(entt::entity entity, const Box& box, const Box& contour);
+  void Remove(entt::entity entity);
+  static glm::ivec2 GetCell(glm::vec2 pos);
+  static bool Overlaps(const Box& a, const Box& b);
+  std::vector<entt::entity> Query(const Box& area) const;
+
+  // the sheet coordinates are normalized, entities dragged outside of it end up in the border cells
+  static constexpr int s_gridSize = 16;
+  std::array<std::vector<entt::entity>, s_gridSize * s_gridSize> m_cells;
+  std::unordered_map<entt::entity, Box> m_boxes;
+  ContourBounds m_contours;
+  std::unordered_map<entt::entity, size_t> m_contourSlots;
+  entt::registry* m_registry = nullptr;
+};
+
+} // namespace medicimage
@@ -0,0 +1,116 @@
+#include "image_handling/glyph_atlas.h"
+#include "core/log.h"
+#include "imgui_internal.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace medicimage
+{
+
+bool TextLayout::Matches(const std::string& otherText, int otherFontSize, cv::Size otherCanvasSize) const
+{
+  return fontSize == otherFontSize && canvasSize == otherCanvasSize && text == otherText;
+}
+
+GlyphAtlas& GlyphAtlas::GetInstance()
+{
+  // the atlas is only read after it is built, so the drawing threads can share it
+  static GlyphAtlas s_instance;
+  return s_instance;
+}
+
+const ImWchar* GlyphAtlas::GetGlyphRanges()
+{
+  // latin-1 and latin extended-A, so the accented letters of the names are also covered
+  static const ImWchar ranges[] = {0x0020, 0x00FF, 0x0100, 0x017F, 0};
+  return ranges;
+}
+
+GlyphAtlas::GlyphAtlas()
+{
+  ImFontConfig config;
+  config.OversampleH = 2;
+  config.OversampleV = 2;
+  m_atlas.Flags |= ImFontAtlasFlags_NoMouseCursors | ImFontAtlasFlags_NoBakedLines;
+  m_font = m_atlas.AddFontFromFileTTF(s_fontPath, s_basePixelSize, &config, GetGlyphRanges());
+  if(m_font == nullptr)
+  {
+    APP_CORE_ERR("Cannot load the annotation font:{}", s_fontPath);
+    return;
+  }
+
+  unsigned char* pixels = nullptr;
+  int width = 0, height = 0;
+  m_atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+  m_pixels = cv::Mat(height, width, CV_8UC1, pixels);
+  APP_CORE_INFO("Glyph atlas for the annotations is built, size:{}x{}", width, height);
+}
+
+std::shared_ptr<const TextLayout> GlyphAtlas::LayoutText(const std::string& text, int fontSize, cv::Size canvasSize) const
+{
+  auto layout = std::make_shared<TextLayout>();
+  layout->text = text;
+  layout->fontSize = fontSize;
+  layout->canvasSize = canvasSize;
+  if(m_font == nullptr)
+    return layout;
+
+  // glyph runs: the quads are placed along the baseline with the advances of the font
+  const float scale = GetPixelSize(fontSize) / m_font->FontSize;
+  const float ascent = m_font->Ascent * scale;
+  const float descent = -m_font->Descent * scale;
+  float penX = 0.0f;
+  const char* end = text.data() + text.size();
+  for(const char* it = text.data(); it < end;)
+  {
+    unsigned int c = 0;
+    it += ImTextCharFromUtf8(&c, it, end);
+    if(c == 0)
+      break;
+    const ImFontGlyph* glyph = m_font->FindGlyph(static_cast<ImWchar>(c));
+    if(glyph == nullptr)
+      continue;
+    if(glyph->Visible)
+    {
+      GlyphQuad quad;
+      quad.source = cv::Rect(cv::Point(cvRound(glyph->U0 * m_pixels.cols), cvRound(glyph->V0 * m_pixels.rows)), 
+        cv::Point(cvRound(glyph->U1 * m_pixels.cols), cvRound(glyph->V1 * m_pixels.rows)));
+      quad.target = cv::Rect2f(penX + glyph->X0 * scale, glyph->Y0 * scale - ascent, (glyph->X1 - glyph->X0) * scale, (glyph->Y1 - glyph->Y0) * scale);
+      layout->glyphs.push_back(quad);
+    }
+    penX += glyph->AdvanceX * scale;
+  }
+
+  const int top = static_cast<int>(std::ceil(ascent));
+  layout->box = cv::Rect(0, -top, static_cast<int>(std::ceil(penX)), top + static_cast<int>(std::ceil(descent)));
+  if(canvasSize.area() != 0)
+    layout->boxSize = {static_cast<float>(layout->box.width) / canvasSize.width, static_cast<float>(top) / canvasSize.height};
+  if(layout->box.empty())
+    return layout;
+
+  // the quads are blitted into the coverage once, the drawing blends only the composed box
+  cv::Mat coverage(layout->box.size(), CV_8UC1, cv::Scalar::all(0));
+  const cv::Rect bounds(0, 0, coverage.cols, coverage.rows);
+  cv::Mat glyphPixels;
+  for(const auto& quad : layout->glyphs)
+  {
+    const cv::Rect target(cvRound(quad.target.x) - layout->box.x, cvRound(quad.target.y) - layout->box.y, 
+      std::max(1, cvRound(quad.target.width)), std::max(1, cvRound(quad.target.height)));
+    const cv::Rect visible = target & bounds;
+    if(visible.empty() || quad.source.empty())
+      continue;
+    const int interpolation = target.width < quad.source.width ? cv::INTER_AREA : cv::INTER_LINEAR;
+    cv::resize(m_pixels(quad.source), glyphPixels, target.size(), 0.0, 0.0, interpolation);
+    cv::Mat destination = coverage(visible);
+    cv::max(destination, glyphPixels(cv::Rect(visible.tl() - target.tl(), visible.size())), destination);
+  }
+  cv::Mat bgrCoverage;
+  cv::cvtColor(coverage, bgrCoverage, cv::COLOR_GRAY2BGR);
+  bgrCoverage.copyTo(layout->coverage);
+  return layout;
+}
+
+} // namespace medicimage
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <opencv2/core.hpp>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace medicimage
+{
+
+// a glyph of the atlas placed on the line, the target is in pixels relative to the start of the baseline
+struct GlyphQuad
+{
+  cv::Rect source;
+  cv::Rect2f target;
+};
+
+/// @brief The annotation text laid out with the glyphs of the atlas. It is built once and cached by the text component,
+///         only a different text, font size or canvas size needs a new one
+struct TextLayout
+{
+  bool Matches(const std::string& otherText, int otherFontSize, cv::Size otherCanvasSize) const;
+
+  std::string text;
+  int fontSize = 0;
+  cv::Size canvasSize;
+  std::vector<GlyphQuad> glyphs;
+  cv::Rect box;                   // the white background in pixels, relative to the start of the baseline
+  cv::UMat coverage;              // the glyphs composed into the box, blended onto the canvas in one step
+  glm::vec2 boxSize{0.0f, 0.0f};  // the box above the baseline, relative to the canvas size
+};
+
+/// @brief Calibri rasterized once into an alpha atlas, the annotation text is composed from its glyphs, so it is
+///         anti-aliased and it does not need the Hershey fonts' per frame rendering
+class GlyphAtlas
+{
+public:
+  static GlyphAtlas& GetInstance();
+  std::shared_ptr<const TextLayout> LayoutText(const std::string& text, int fontSize, cv::Size canvasSize) const;
+  // the height of the font in canvas pixels
+  static float GetPixelSize(int fontSize) { return fontSize * s_pixelsPerFontSize; }
+  // the characters in the atlas, the live text overlay loads its font with the same ones
+  static const ImWchar* GetGlyphRanges();
+private:
+  GlyphAtlas();
+  ImFontAtlas m_atlas;
+  ImFont* m_font = nullptr;
+  cv::Mat m_pixels; // the alpha texture of the atlas, owned by the atlas
+  static constexpr const char* s_fontPath = "assets/fonts/calibri/calibri_regular.ttf";
+  static constexpr float s_basePixelSize = 64.0f;     // the glyphs are scaled from this size
+  static constexpr float s_pixelsPerFontSize = 34.0f; // about the height of the Hershey font used before
+};
+
+} // namespace medicimage
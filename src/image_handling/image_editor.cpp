@@ -6,7 +6,7 @@
 #include "image_editor.h"
 namespace medicimage
 {
-cv::UMat ImageEditor::s_image;
+thread_local cv::UMat ImageEditor::s_image;
 static void DumpTexture(ID3D11Texture2D* texture)
 {
   // create texture for copy back data from GPU
@@ -96,6 +96,20 @@ void ImageEditor::End(Texture2D* texture)
   cv::directx::convertToD3D11Texture2D(s_image, texture->GetTexturePtr());
 }
 
+void ImageEditor::Begin(cv::UMat& layer)
+{
+  std::swap(s_image, layer);
+}
+
+void ImageEditor::End(cv::UMat& layer, Texture2D* texture)
+{
+  // the layer stays BGR, only the uploaded copy is converted
+  thread_local cv::UMat rgba;
+  cv::cvtColor(s_image, rgba, cv::COLOR_BGR2RGBA);
+  cv::directx::convertToD3D11Texture2D(rgba, texture->GetTexturePtr());
+  std::swap(s_image, layer);
+}
+
 
 void ImageEditor::DrawCircle(glm::vec2 center, float radius, glm::vec4 color, float thickness, bool filled)
 {
@@ -168,17 +182,47 @@ void ImageEditor::DrawLine(glm::vec2 begin, glm::vec2 end, glm::vec4 color, floa
     cv::Scalar(color.b, color.g, color.r), static_cast<int>(thickness));
 }
 
-void ImageEditor::DrawText(glm::vec2 bottomLeft, const std::string &text, int fontSize, float thickness)
+void ImageEditor::DrawPolyline(std::span<const glm::vec2> points, glm::vec2 offset, glm::vec4 color, float thickness)
 {
-  int baseline = 0;
+  if(points.size() < 2)
+    return;
+  // the scaled points are kept between the calls, per thread like the canvas
+  thread_local std::vector<cv::Point> scaledPoints;
   glm::vec2 imageSize = {s_image.cols, s_image.rows};
-  cv::Point scaledBottomLeft{ static_cast<int>(bottomLeft.x * imageSize.x), static_cast<int>(bottomLeft.y * imageSize.y) };
-  constexpr auto backgroundScaler = 1.0;
-  auto textSize = cv::getTextSize(text, s_defaultFont, fontSize * backgroundScaler, thickness, &baseline);
-  auto bgTopRight = scaledBottomLeft + cv::Point{ textSize.width, -textSize.height };
-  auto bgBottomLeft = scaledBottomLeft + cv::Point(0, baseline * backgroundScaler);
-  cv::rectangle(s_image, cv::Rect(bgBottomLeft, bgTopRight), cv::Scalar::all(255), -1); // white rectangle behind the text
-  cv::putText(s_image, text, scaledBottomLeft, s_defaultFont, fontSize, cv::Scalar::all(0), thickness);
+  scaledPoints.clear();
+  for(const auto& point : points)
+  {
+    glm::vec2 scaledPoint = (point + offset) * imageSize;
+    scaledPoints.emplace_back(static_cast<int>(scaledPoint.x), static_cast<int>(scaledPoint.y));
+  }
+  color *= 255.0;
+
+  const cv::Point* curve = scaledPoints.data();
+  const int pointCount = static_cast<int>(scaledPoints.size());
+  cv::polylines(s_image, &curve, &pointCount, 1, false, cv::Scalar(color.b, color.g, color.r), static_cast<int>(thickness));
+}
+
+const TextLayout& ImageEditor::GetTextLayout(std::shared_ptr<const TextLayout>& cache, const std::string& text, int fontSize)
+{
+  const cv::Size canvasSize = s_image.size();
+  if(cache == nullptr || !cache->Matches(text, fontSize, canvasSize))
+    cache = GlyphAtlas::GetInstance().LayoutText(text, fontSize, canvasSize);
+  return *cache;
+}
+
+void ImageEditor::DrawText(glm::vec2 bottomLeft, const TextLayout& layout)
+{
+  if(layout.coverage.empty())
+    return;
+  const cv::Point origin{ static_cast<int>(bottomLeft.x * s_image.cols), static_cast<int>(bottomLeft.y * s_image.rows) };
+  const cv::Rect box = layout.box + origin;
+  const cv::Rect visible = box & cv::Rect(0, 0, s_image.cols, s_image.rows);
+  if(visible.empty())
+    return;
+  // black glyphs alpha blended onto the white background behind the text
+  cv::UMat canvas = s_image(visible);
+  canvas.setTo(cv::Scalar::all(255));
+  cv::subtract(canvas, layout.coverage(cv::Rect(visible.tl() - box.tl(), visible.size())), canvas);
 }
 
 
@@ -205,18 +249,12 @@ void ImageEditor::DrawSpline(glm::vec2 begin, glm::vec2 middle, glm::vec2 end, i
   }
 }
 
-glm::vec2 ImageEditor::GetTextBoundingBox(const std::string &text, int fontSize, float thickness)
-{
-  int baseline = 0;
-  auto textSize = cv::getTextSize(text, s_defaultFont, fontSize, thickness, &baseline); 
-  return glm::vec2{static_cast<float>(textSize.width) / static_cast<float>(s_image.cols), static_cast<float>(textSize.height) / static_cast<float>(s_image.rows)};
-}
-
-cv::UMat ImageEditor::AddFooter(cv::UMat image, const std::string& footerText)
+template<typename ImageType>
+ImageType ImageEditor::AddFooter(const ImageType& image, const std::string& footerText)
 {
   // add a sticker to the bottom with the image name, date and time
   // assuming the original texture has 1920x1080 resolution, expanding with 20-20 pixels left/right and 30 bottom, 20 top
-  cv::UMat borderedImage;
+  ImageType borderedImage;
   cv::copyMakeBorder(image, borderedImage, s_topBorder, s_bottomBorder, s_sideBorder, s_sideBorder, cv::BORDER_CONSTANT , cv::Scalar{255,255,255} ); // adding white border
   cv::putText(borderedImage, footerText, cv::Point{s_topBorder, borderedImage.rows - s_topBorder}, s_defaultFont, 1, cv::Scalar{0,0,0}, 3);
   return borderedImage;
@@ -267,4 +305,9 @@ std::unique_ptr<Texture2D> ImageEditor::AddImageFooter(const std::string& footer
   return std::move(dstTexture);
 }
 
+cv::Mat ImageEditor::AddImageFooter(const std::string& footerText, const cv::Mat& image)
+{
+  return AddFooter(image, footerText);
+}
+
 } // namespace medicimage
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/texture.h"
+#include "image_handling/glyph_atlas.h"
 #include "imgui.h"
 
 #include <d3d11.h>
@@ -11,6 +12,7 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include <span>
 #include <glm/glm.hpp>
 
 namespace medicimage
@@ -25,24 +27,35 @@ public:
   static std::unique_ptr<Texture2D> AddImageFooter(const std::string& footerText, Texture2D* texture);
   static std::unique_ptr<Texture2D> ReplaceImageFooter(const std::string& footerText, Texture2D* texture);
   static std::unique_ptr<Texture2D> RemoveFooter(Texture2D* texture);
+  // CPU variant for the stills coming directly from the camera, the image stays in BGR
+  static cv::Mat AddImageFooter(const std::string& footerText, const cv::Mat& image);
 
   static void Begin(Texture2D* texture);
   static void End(Texture2D* texture);
+  // the canvas is swapped with a BGR layer kept by the caller, so drawing can continue on it in the next frame;
+  // End() uploads the canvas into the texture and stores it in the layer
+  static void Begin(cv::UMat& layer);
+  static void End(cv::UMat& layer, Texture2D* texture);
   static void DrawCircle(glm::vec2 center, float radius, glm::vec4 color, float thickness, bool filled);
   static void DrawRectangle(glm::vec2 topleft, glm::vec2 bottomright, glm::vec4 color, float thickness, bool filled);
   static void DrawArrow(glm::vec2 begin, glm::vec2 end, glm::vec4 color, float thickness, double tipLengith);
   static void DrawLine(glm::vec2 begin, glm::vec2 end, glm::vec4 color, float thickness, double tipLengith);
-  static void DrawText(glm::vec2 bottomLeft, const std::string& text, int fontSize, float thickness);
+  // the points are relative to the offset, the whole outline is a single stroke
+  static void DrawPolyline(std::span<const glm::vec2> points, glm::vec2 offset, glm::vec4 color, float thickness);
+  // the cached layout is reused while its text, font size and the canvas size are the same, otherwise it is rebuilt
+  static const TextLayout& GetTextLayout(std::shared_ptr<const TextLayout>& cache, const std::string& text, int fontSize);
+  static void DrawText(glm::vec2 bottomLeft, const TextLayout& layout);
   static void DrawSpline(glm::vec2 begin, glm::vec2 middle, glm::vec2 end, int lineCount, glm::vec4 color, float thickness);
-  static glm::vec2 GetTextBoundingBox(const std::string& text, int fontSize, float thickness);
 private:
-  static cv::UMat AddFooter(cv::UMat image, const std::string& footerText);
+  template<typename ImageType>
+  static ImageType AddFooter(const ImageType& image, const std::string& footerText);
   static constexpr int s_sideBorder = 10;
   static constexpr int s_topBorder = 10;
   static constexpr int s_bottomBorder = 50;
   static constexpr auto s_defaultFont = cv::FONT_HERSHEY_SIMPLEX;
   // TODO: move this into a better place
-  static cv::UMat s_image;
+  // one canvas per thread, so several sheets can be drawn at the same time
+  static thread_local cv::UMat s_image;
   cv::ocl::Context m_context;
 };
 
@@ -1,6 +1,7 @@
 #include "image_handling/image_saver.h"
 #include "core/log.h"
 #include "image_handling/image_editor.h"
+#include "drawing/drawing_sheet.h"
 
 #include "opencv2/core/directx.hpp"
 #include "opencv2/core/ocl.hpp"
@@ -128,6 +129,8 @@ void ImageDocContainer::CreatePatientDir()
     APP_CORE_INFO("Directory:{} already created, loading images from it.", m_dirPath.string());
   if(!(std::filesystem::create_directory(m_dirPath/"thumbs")))
     APP_CORE_INFO("thumbs folder alredy created for patient:{}, using that one", m_uuid);
+  if(!(std::filesystem::create_directory(m_dirPath/"annotations")))
+    APP_CORE_INFO("annotations folder alredy created for patient:{}, using that one", m_uuid);
 
 }
 
@@ -139,13 +142,30 @@ void ImageDocContainer::LoadImage(std::string imageName, const std::filesystem::
   auto it = std::find_if(m_savedImages.begin(), m_savedImages.end(), findByName);
   if(it == m_savedImages.end())
   {
+    // an annotated document is loaded from its clean frame and the sidecar, the sheet draws the annotations onto it
+    std::ifstream sidecar(GetAnnotationsPath(imageName), std::ios::binary);
+    if(sidecar.good() && std::filesystem::exists(GetOriginalPath(imageName)))
+    {
+      std::vector<char> annotations(std::istreambuf_iterator<char>(sidecar), std::istreambuf_iterator<char>{});
+      if(DrawingSheet::CheckAnnotations(annotations))
+      {
+        ImageDocument doc(std::make_unique<Texture2D>(imageName, GetOriginalPath(imageName).string()), filePath.stem().string(), timestamp);
+        doc.annotations = std::move(annotations);
+        doc.thumbnail = std::make_shared<Texture2D>(imageName + "-thumb", (m_dirPath / "thumbs" / filePath.filename()).string());
+        m_savedImages.push_back(std::move(doc));
+        return;
+      }
+      // the annotated image still has the annotations burnt in, it is better than the clean frame without them
+      APP_CORE_WARN("The annotations of:{} are rejected, the document is opened from its annotated image", imageName);
+    }
+
     auto texture = std::make_unique<Texture2D>(imageName, filePath.string()); 
     texture = std::move(ImageEditor::RemoveFooter(texture.get()));
     m_savedImages.push_back({std::move(texture), filePath.stem().string(), timestamp});
   }
 }
 
-std::vector<ImageDocument>::iterator ImageDocContainer::AddImage(Texture2D& texture, bool hasFooter)
+std::string ImageDocContainer::NextDocumentName()
 {
   json jsonData;
   std::ifstream fs(m_descriptorsFileName);
@@ -162,17 +182,47 @@ std::vector<ImageDocument>::iterator ImageDocContainer::AddImage(Texture2D& text
       APP_CORE_INFO("Last doc name:{}", lastDocName.c_str());
     }
   } 
-  std::string name = m_uuid + "_" + std::to_string(docNumber);
+  return m_uuid + "_" + std::to_string(docNumber);
+}
+
+cv::Mat ImageDocContainer::WriteDocumentFiles(const std::string& name, cv::InputArray borderedImage)
+{
+  std::string fileName = name + ".jpeg";
+  std::filesystem::path imagePath = m_dirPath / fileName;
+  std::filesystem::path thumbImagePath = m_dirPath / "thumbs" / fileName;
+
+  cv::imwrite(imagePath.string(), borderedImage);
+  // keep the aspect ratio of the image, the stills can have other resolution than the preview
+  constexpr int thumbWidth = 640;
+  cv::Size imageSize = borderedImage.size();
+  int thumbHeight = std::max(1, thumbWidth * imageSize.height / std::max(1, imageSize.width));
+  cv::Mat thumbImage;
+  cv::resize(borderedImage, thumbImage, cv::Size(thumbWidth, thumbHeight), 0.0, 0.0, cv::INTER_AREA);
+  cv::imwrite(thumbImagePath.string(), thumbImage);
+  m_fileLogger->LogFileOperation(fileName, FileLogger::FileOperation::FILE_SAVE);
+  UpdateDocListFile();
+  return thumbImage;
+}
+
+void ImageDocContainer::WriteAnnotationFiles(const std::string& name, cv::InputArray original, const std::vector<char>& annotations)
+{
+  // fast png compression, the frame is written once and it is read back only when the document is opened
+  cv::imwrite(GetOriginalPath(name).string(), original, {cv::IMWRITE_PNG_COMPRESSION, 1});
+  std::ofstream sidecar(GetAnnotationsPath(name), std::ios::binary | std::ios::trunc);
+  sidecar.write(annotations.data(), static_cast<std::streamsize>(annotations.size()));
+  if(!sidecar.good())
+    APP_CORE_ERR("Something went wrong writing the annotations of:{}", name);
+}
+
+std::vector<ImageDocument>::iterator ImageDocContainer::AddImage(Texture2D& texture, bool hasFooter)
+{
+  std::string name = NextDocumentName();
   ImageDocument doc(std::make_unique<Texture2D>(texture.GetTexturePtr(), texture.GetName()));
   doc.documentId = name;
   doc.timestamp = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
   if(hasFooter)
     doc.texture = ImageEditor::RemoveFooter(doc.texture.get());
   m_savedImages.push_back(doc);
-    
-  name += ".jpeg";
-  std::filesystem::path imagePath = m_dirPath / name;
-  std::filesystem::path thumbImagePath = m_dirPath / "thumbs" / name;
   
   std::string footerText = doc.GenerateFooterText();
   std::unique_ptr<Texture2D> borderedImage;
@@ -181,11 +231,52 @@ std::vector<ImageDocument>::iterator ImageDocContainer::AddImage(Texture2D& text
   cv::UMat ocvImage;
   cv::directx::convertFromD3D11Texture2D(borderedImage->GetTexturePtr(), ocvImage);
   cv::cvtColor(ocvImage, ocvImage, cv::COLOR_RGBA2BGR);
-  cv::imwrite(imagePath.string(), ocvImage);
-  cv::resize(ocvImage, ocvImage, cv::Size(640,360) );
-  cv::imwrite(thumbImagePath.string(), ocvImage);
-  m_fileLogger->LogFileOperation(name, FileLogger::FileOperation::FILE_SAVE);
-  UpdateDocListFile();
+  WriteDocumentFiles(name, ocvImage);
+  return m_savedImages.end();
+}
+
+std::vector<ImageDocument>::iterator ImageDocContainer::AddImage(const cv::Mat& image)
+{
+  std::string name = NextDocumentName();
+  // the document texture is uploaded once from the CPU image, the files are written from the same CPU image
+  cv::Mat rgbaImage;
+  cv::cvtColor(image, rgbaImage, cv::COLOR_BGR2RGBA);
+  ImageDocument doc(std::make_unique<Texture2D>(name, rgbaImage.cols, rgbaImage.rows, rgbaImage.data, static_cast<unsigned int>(rgbaImage.step)));
+  doc.documentId = name;
+  doc.timestamp = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::string footerText = doc.GenerateFooterText();
+  m_savedImages.push_back(std::move(doc));
+
+  cv::Mat borderedImage = ImageEditor::AddImageFooter(footerText, image);
+  WriteDocumentFiles(name, borderedImage);
+  return m_savedImages.end();
+}
+
+std::vector<ImageDocument>::iterator ImageDocContainer::AddImage(Texture2D& annotated, Texture2D& original, std::vector<char> annotations)
+{
+  std::string name = NextDocumentName();
+  ImageDocument doc(std::make_unique<Texture2D>(original.GetTexturePtr(), original.GetName()), name,
+    std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+  doc.annotations = std::move(annotations);
+  std::string footerText = doc.GenerateFooterText();
+  m_savedImages.push_back(doc);
+
+  // the annotated image gets the footer of the new document
+  auto annotatedImage = ImageEditor::RemoveFooter(&annotated);
+  auto borderedImage = ImageEditor::AddImageFooter(footerText, annotatedImage.get());
+  cv::UMat ocvImage;
+  cv::directx::convertFromD3D11Texture2D(borderedImage->GetTexturePtr(), ocvImage);
+  cv::cvtColor(ocvImage, ocvImage, cv::COLOR_RGBA2BGR);
+  cv::Mat thumbImage = WriteDocumentFiles(name, ocvImage);
+
+  cv::UMat originalImage;
+  cv::directx::convertFromD3D11Texture2D(original.GetTexturePtr(), originalImage);
+  cv::cvtColor(originalImage, originalImage, cv::COLOR_RGBA2BGR);
+  WriteAnnotationFiles(name, originalImage, m_savedImages.back().annotations);
+
+  cv::Mat rgbaThumb;
+  cv::cvtColor(thumbImage, rgbaThumb, cv::COLOR_BGR2RGBA);
+  m_savedImages.back().thumbnail = std::make_shared<Texture2D>(name + "-thumb", rgbaThumb.cols, rgbaThumb.rows, rgbaThumb.data, static_cast<unsigned int>(rgbaThumb.step));
   return m_savedImages.end();
 }
 
@@ -199,6 +290,9 @@ void ImageDocContainer::DeleteImage(std::vector<ImageDocument>::const_iterator i
       APP_CORE_ERR("Something went wrong deleting this image:{}", imagePath.string());
     else
     {
+      // the sidecar files exist only for the annotated documents
+      std::filesystem::remove(GetAnnotationsPath(it->documentId));
+      std::filesystem::remove(GetOriginalPath(it->documentId));
       m_fileLogger->LogFileOperation(it->documentId + ".jpeg", FileLogger::FileOperation::FILE_DELETE);
       m_savedImages.erase(it);
       UpdateDocListFile();
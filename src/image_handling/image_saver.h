@@ -3,6 +3,7 @@
 #include <filesystem>
 #include "renderer/texture.h"
 #include <unordered_map>
+#include <opencv2/core.hpp>
 
 namespace medicimage
 {
@@ -41,12 +42,16 @@ public:
     timestamp = doc.timestamp;
     documentId = doc.documentId;
     texture = std::make_unique<Texture2D>(doc.texture->GetTexturePtr(), "texture");
+    annotations = doc.annotations;
+    thumbnail = doc.thumbnail;
   }
   ImageDocument& operator=(const ImageDocument& doc)
   {
     timestamp = doc.timestamp;
     documentId = doc.documentId;
     texture = std::make_unique<Texture2D>(doc.texture->GetTexturePtr(), "texture");
+    annotations = doc.annotations;
+    thumbnail = doc.thumbnail;
     return *this;
   }
   std::unique_ptr<Texture2D> DrawFooter();
@@ -61,6 +66,10 @@ public:
   std::time_t timestamp;
   std::string documentId = "";
   std::unique_ptr<Texture2D> texture;
+  // annotated documents: the texture is the clean frame and the annotations are the serialized drawing sheet,
+  // the thumbnail is the annotated image, so the thumbnail strip does not need the sheet
+  std::vector<char> annotations;
+  std::shared_ptr<Texture2D> thumbnail;
 };
 
 class ImageDocContainer
@@ -73,6 +82,11 @@ public:
   // times, when it is selected from the thumbnails, edited and then saved as a ANNOTATED image. The original pair can be found
   // by the texture name
   std::vector<ImageDocument>::iterator AddImage(Texture2D& texture, bool hasFooter);
+  // saves a BGR still coming directly from the camera, without a round trip trough the GPU
+  std::vector<ImageDocument>::iterator AddImage(const cv::Mat& image);
+  // saves an edited document: the annotated image (with footer) is written as usual, the clean frame is kept lossless
+  // and the annotations go to a sidecar, so the document can be edited again without re-encoding the pixels
+  std::vector<ImageDocument>::iterator AddImage(Texture2D& annotated, Texture2D& original, std::vector<char> annotations);
   void ClearSavedImages();
   void LoadPatientsFolder();
   void CreatePatientDir();
@@ -85,6 +99,11 @@ public:
   const std::vector<ImageDocument>& GetSavedImages(){return m_savedImages;}
 private:
   void UpdateDocListFile();
+  std::string NextDocumentName();
+  cv::Mat WriteDocumentFiles(const std::string& name, cv::InputArray borderedImage);
+  void WriteAnnotationFiles(const std::string& name, cv::InputArray original, const std::vector<char>& annotations);
+  std::filesystem::path GetAnnotationsPath(const std::string& name) { return m_dirPath / "annotations" / (name + ".annot"); }
+  std::filesystem::path GetOriginalPath(const std::string& name) { return m_dirPath / "annotations" / (name + ".png"); }
   std::string m_uuid;
   std::filesystem::path m_dirPath;
   std::vector<ImageDocument> m_savedImages;
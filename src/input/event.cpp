@@ -2,6 +2,7 @@
 
 #include "input/event.h"
 #include "input/key_event.h"
+#include "input/mouse_event.h"
 #include "input/application_event.h"
 #include "backends/imgui_impl_sdl.h"
 #include "backends/imgui_impl_dx11.h"
@@ -21,19 +22,41 @@ EventInputHandler::EventInputHandler(std::shared_ptr<ImguiLayer> imgui, SDL_Wind
 }
 
 EventInputHandler::~EventInputHandler()
-{}
+{
+  FlushEvents();
+}
 
 void EventInputHandler::FlushEvents()
 {
-  for(auto event : m_events)
-    delete event;
-  m_events.clear();
+  for(auto event : GetCollectedEvents())
+    event->~Event();
+  m_eventCount = 0;
+  m_arenaUsed = 0;
+}
+
+void EventInputHandler::PushMouseMoved(float x, float y)
+{
+  // near the end of the queue the motions are merged into the last one, only their path is lost, not the position
+  if(m_eventCount >= s_maxEvents - s_reservedEvents && m_events[m_eventCount - 1]->GetEventType() == EventType::MouseMoved)
+    *static_cast<MouseMovedEvent*>(m_events[m_eventCount - 1]) = MouseMovedEvent(x, y);
+  else
+    PushEvent<MouseMovedEvent>(x, y);
+}
+
+// with multiple viewports ImGui works in screen space, otherwise in the coordinates of the main window
+static ImVec2 ToImguiPos(Uint32 windowID, int x, int y)
+{
+  int windowX = 0, windowY = 0;
+  if(ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+    SDL_GetWindowPosition(SDL_GetWindowFromID(windowID), &windowX, &windowY);
+  return {static_cast<float>(x + windowX), static_cast<float>(y + windowY)};
 }
 
 void EventInputHandler::PollEvents()
 {
   SDL_Event event;
-  while (SDL_PollEvent(&event))
+  // every SDL event adds at most one, when the queue is full the rest stays in the SDL queue for the next frame
+  while (m_eventCount < s_maxEvents && SDL_PollEvent(&event))
   {
     ImGui_ImplSDL2_ProcessEvent(&event);
     if (event.type == SDL_QUIT)
@@ -43,7 +66,7 @@ void EventInputHandler::PollEvents()
     else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(m_window))
     {
       APP_CORE_INFO("Close event recieved");
-      m_events.push_back(new WindowCloseEvent());
+      PushEvent<WindowCloseEvent>();
     }
     else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED && event.window.windowID == SDL_GetWindowID(m_window))
     {
@@ -52,13 +75,28 @@ void EventInputHandler::PollEvents()
     else if(event.type == SDL_TEXTINPUT)
     {
       // TODO: do UTF8 decoding here
-      auto textInput = new KeyTextInputEvent(event.text.text); 
-      m_events.push_back(textInput);
+      PushEvent<KeyTextInputEvent>(event.text.text);
+    }
+    else if(event.type == SDL_MOUSEMOTION)
+    {
+      const auto pos = ToImguiPos(event.motion.windowID, event.motion.x, event.motion.y);
+      PushMouseMoved(pos.x, pos.y);
+    }
+    else if(event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP)
+    {
+      const auto pos = ToImguiPos(event.button.windowID, event.button.x, event.button.y);
+      if(event.type == SDL_MOUSEBUTTONDOWN)
+        PushEvent<MouseButtonPressedEvent>(event.button.button, pos.x, pos.y);
+      else
+        PushEvent<MouseButtonReleasedEvent>(event.button.button, pos.x, pos.y);
+    }
+    else if(event.type == SDL_MOUSEWHEEL)
+    {
+      PushEvent<MouseScrolledEvent>(static_cast<float>(event.wheel.x), static_cast<float>(event.wheel.y));
     }
     else if(event.type == SDL_KEYDOWN)
     {
-      auto keyDownEvent = new KeyPressedEvent(event.key.keysym.sym);  // TODO: proper mapping of SDL keys into KeyPressedEvent keymap
-      m_events.push_back(keyDownEvent);
+      PushEvent<KeyPressedEvent>(event.key.keysym.sym);  // TODO: proper mapping of SDL keys into KeyPressedEvent keymap
     }
   }
 }
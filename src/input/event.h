@@ -1,6 +1,10 @@
 #pragma once
 #include <memory>
-#include <vector>
+#include <array>
+#include <span>
+#include <new>
+#include <cstddef>
+#include <cassert>
 #include "ui/imgui_layer.h"
 #include <functional>
 #include <SDL.h>
@@ -41,7 +45,7 @@ class Event {
   friend class EventDispatcher;
 public:
   Event() = default;
-  ~Event(){}
+  virtual ~Event() = default;
   virtual EventType GetEventType() const = 0;
   virtual const char* GetName() const = 0;
   virtual int GetCategoryFlags() const = 0;
@@ -86,11 +90,32 @@ public:
   ~EventInputHandler();
   void PollEvents();
   void FlushEvents();
-  std::vector<Event*>& GetCollectedEvents(){return m_events;}
+  // the events of the frame, valid until FlushEvents
+  std::span<Event* const> GetCollectedEvents() const {return {m_events.data(), m_eventCount};}
 private:
+  // the events are constructed in a fixed arena, which is reset every frame, so the polling does not allocate;
+  // every event fits into its share of the arena, so only the number of events has to be checked
+  template<typename T, typename... Args>
+  void PushEvent(Args&&... args)
+  {
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+    static_assert(sizeof(T) + alignof(T) <= s_maxEventSize);
+    assert(m_eventCount < s_maxEvents && "The event queue is full");
+    const size_t offset = (m_arenaUsed + alignof(T) - 1) & ~(alignof(T) - 1);
+    m_events[m_eventCount++] = new (m_arena.data() + offset) T(std::forward<Args>(args)...);
+    m_arenaUsed = offset + sizeof(T);
+  }
+  void PushMouseMoved(float x, float y);
+
   SDL_Window* m_window;
   std::shared_ptr<ImguiLayer> m_imguiLayer;
-  std::vector<Event*> m_events;
+  static constexpr size_t s_maxEvents = 512; // a high rate pen can send a few hundred motion events between two frames
+  static constexpr size_t s_reservedEvents = 32; // the last slots are not taken by the motion, the clicks and keys fit in
+  static constexpr size_t s_maxEventSize = 64;
+  alignas(std::max_align_t) std::array<std::byte, s_maxEvents * s_maxEventSize> m_arena;
+  std::array<Event*, s_maxEvents> m_events;
+  size_t m_arenaUsed = 0;
+  size_t m_eventCount = 0;
 };
 
 } // namespace medicimage
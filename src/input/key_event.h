@@ -4,6 +4,9 @@
 #include "input/key_codes.h"
 
 #include <sstream>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
 
 namespace medicimage
 {
@@ -43,11 +46,17 @@ private:
 class KeyTextInputEvent : public Event
 {
 public:
-  KeyTextInputEvent(const std::string& inputText) : m_inputText(inputText) {}
+  // the text is copied into the event, SDL limits it to SDL_TEXTINPUTEVENT_TEXT_SIZE bytes with the terminator
+  KeyTextInputEvent(const char* inputText)
+  {
+    const size_t length = std::min(std::strlen(inputText), s_maxTextSize - 1);
+    std::memcpy(m_inputText, inputText, length);
+    m_inputText[length] = '\0';
+  }
   EVENT_CLASS_CATEGORY(EventCategoryInput)
   EVENT_CLASS_TYPE(KeyTextInput)
 
-  const std::string& GetInputTextText() const { return m_inputText; }
+  std::string_view GetInputTextText() const { return m_inputText; }
 
   std::string ToString() const override 
   {
@@ -56,7 +65,8 @@ public:
     return ss.str(); 
   }
 private:
-  std::string m_inputText;
+  static constexpr size_t s_maxTextSize = SDL_TEXTINPUTEVENT_TEXT_SIZE;
+  char m_inputText[s_maxTextSize];
 };
 
 } // namespace medicimage
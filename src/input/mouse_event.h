@@ -0,0 +1,113 @@
+#pragma once
+
+#include "input/event.h"
+
+#include <sstream>
+
+namespace medicimage
+{
+
+// every SDL motion event becomes one, so the drawing tools can sample the mouse (or pen) faster than the frame rate
+class MouseMovedEvent : public Event
+{
+public:
+  // the position is in ImGui's coordinate space (screen space, when the viewports are enabled)
+  MouseMovedEvent(float x, float y) : m_mouseX(x), m_mouseY(y) {}
+
+  float GetX() const { return m_mouseX; }
+  float GetY() const { return m_mouseY; }
+
+  std::string ToString() const override
+  {
+    std::stringstream ss;
+    ss << "MouseMovedEvent: " << m_mouseX << ", " << m_mouseY;
+    return ss.str();
+  }
+
+  EVENT_CLASS_TYPE(MouseMoved)
+  EVENT_CLASS_CATEGORY(EventCategoryMouse | EventCategoryInput)
+private:
+  float m_mouseX, m_mouseY;
+};
+
+using MouseCode = uint8_t;
+
+namespace Mouse
+{
+  enum : MouseCode
+  {
+    // button mapping from SDL buttons
+    ButtonLeft = SDL_BUTTON_LEFT,
+    ButtonMiddle = SDL_BUTTON_MIDDLE,
+    ButtonRight = SDL_BUTTON_RIGHT
+  };
+}
+
+class MouseButtonEvent : public Event
+{
+public:
+  MouseCode GetMouseButton() const { return m_button; }
+  float GetX() const { return m_mouseX; }
+  float GetY() const { return m_mouseY; }
+
+  EVENT_CLASS_CATEGORY(EventCategoryMouse | EventCategoryInput | EventCategoryMouseButton)
+protected:
+  // the position of the click in the same space as the MouseMovedEvent, the frame may already be elsewhere
+  MouseButtonEvent(const MouseCode button, float x, float y) : m_button(button), m_mouseX(x), m_mouseY(y) {}
+
+  MouseCode m_button;
+  float m_mouseX, m_mouseY;
+};
+
+class MouseButtonPressedEvent : public MouseButtonEvent
+{
+public:
+  MouseButtonPressedEvent(const MouseCode button, float x, float y) : MouseButtonEvent(button, x, y) {}
+
+  std::string ToString() const override
+  {
+    std::stringstream ss;
+    ss << "MouseButtonPressedEvent: " << static_cast<int>(m_button) << " at " << m_mouseX << ", " << m_mouseY;
+    return ss.str();
+  }
+
+  EVENT_CLASS_TYPE(MouseButtonPressed)
+};
+
+class MouseButtonReleasedEvent : public MouseButtonEvent
+{
+public:
+  MouseButtonReleasedEvent(const MouseCode button, float x, float y) : MouseButtonEvent(button, x, y) {}
+
+  std::string ToString() const override
+  {
+    std::stringstream ss;
+    ss << "MouseButtonReleasedEvent: " << static_cast<int>(m_button) << " at " << m_mouseX << ", " << m_mouseY;
+    return ss.str();
+  }
+
+  EVENT_CLASS_TYPE(MouseButtonReleased)
+};
+
+class MouseScrolledEvent : public Event
+{
+public:
+  MouseScrolledEvent(float xOffset, float yOffset) : m_xOffset(xOffset), m_yOffset(yOffset) {}
+
+  float GetXOffset() const { return m_xOffset; }
+  float GetYOffset() const { return m_yOffset; }
+
+  std::string ToString() const override
+  {
+    std::stringstream ss;
+    ss << "MouseScrolledEvent: " << m_xOffset << ", " << m_yOffset;
+    return ss.str();
+  }
+
+  EVENT_CLASS_TYPE(MouseScrolled)
+  EVENT_CLASS_CATEGORY(EventCategoryMouse | EventCategoryInput)
+private:
+  float m_xOffset, m_yOffset;
+};
+
+} // namespace medicimage
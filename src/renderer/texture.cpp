@@ -32,6 +32,36 @@ namespace medicimage
     CreateSamplerState();
   }
 
+  Texture2D::Texture2D(const std::string& name, unsigned int width, unsigned int height, const void* data, unsigned int rowPitch)
+    : m_fileName("NULL"), m_name(name)
+  {
+    assert(data != nullptr);
+    m_width = width;
+    m_height = height;
+    D3D11_SUBRESOURCE_DATA initData;
+    initData.pSysMem = data;
+    initData.SysMemPitch = rowPitch;
+    initData.SysMemSlicePitch = rowPitch * height;
+
+    ZeroMemory(&m_desc, sizeof(D3D11_TEXTURE2D_DESC));
+    m_desc.Width = m_width;
+    m_desc.Height = m_height;
+    m_desc.MipLevels = 1;
+    m_desc.ArraySize = 1;
+    m_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    m_desc.Usage = D3D11_USAGE_DEFAULT;
+    m_desc.CPUAccessFlags     = 0;
+    m_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    m_desc.SampleDesc.Count = 1;
+    m_desc.SampleDesc.Quality = 0;
+    m_desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED;  // need the SHARED flag for OpenCV(OpenCL) - DirectX interop
+
+    ThrowIfFailed(Renderer::GetInstance().GetDevice()->CreateTexture2D(&m_desc, &initData, &m_texture));
+
+    CreateShaderResourceView();
+    CreateSamplerState();
+  }
+
   Texture2D::Texture2D(const std::string& name, const std::string& filename)
     : m_name(name), m_fileName(filename)
   {
@@ -90,6 +120,12 @@ namespace medicimage
     m_texture->Release();
   }
 
+  void Texture2D::Update(const void* data, unsigned int rowPitch)
+  {
+    assert(data != nullptr);
+    Renderer::GetInstance().GetDeviceContext()->UpdateSubresource(m_texture, 0, nullptr, data, rowPitch, rowPitch * m_height);
+  }
+
   void Texture2D::Load()
   {
     Image image(m_fileName);
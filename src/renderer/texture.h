@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/renderer.h"
+#include "core/frame_timing.h"
 
 #include <string>
 
@@ -18,15 +19,19 @@ private:
 	ID3D11ShaderResourceView* m_resourceView;
 	ID3D11SamplerState* m_samplerState;
 	D3D11_SAMPLER_DESC m_samplerDesc;
+	FrameTimestamps m_frameTimestamps; // only set for textures holding a camera frame
 public:
 	Texture2D(const std::string& name, unsigned int width, unsigned int height);
+  // creates the texture with initial RGBA content, rowPitch is the size of one row in bytes
+  Texture2D(const std::string& name, unsigned int width, unsigned int height, const void* data, unsigned int rowPitch);
 	Texture2D(const std::string& name, const std::string& filename); // TODO: make the filename std::filesystem::path
   Texture2D(ID3D11Texture2D* srcTexture, const std::string& name);
   Texture2D(Texture2D& texture);
   Texture2D& operator=(const Texture2D& texture);
 	~Texture2D();
 
-  void Update();
+  // overwrites the whole content with RGBA data of the same size, without recreating the texture
+  void Update(const void* data, unsigned int rowPitch);
 
 	void Bind(unsigned int slot = 0) const;
 	void Unbind(unsigned int slot = 0) const;
@@ -38,6 +43,8 @@ public:
 	inline const std::string& GetFilepath() const { return m_fileName; }
 
   void SetName(const std::string& name){m_name = name;}
+  void SetFrameTimestamps(const FrameTimestamps& timestamps){m_frameTimestamps = timestamps;}
+  const FrameTimestamps& GetFrameTimestamps() const {return m_frameTimestamps;}
 
   ID3D11ShaderResourceView* GetShaderResourceView() const {return m_resourceView;}
   ID3D11Texture2D* GetTexturePtr() const {return m_texture;}
@@ -14,13 +14,32 @@ void AttributeEditor::OnImguiRender()
   bool open = true;
   ImGui::Begin("Properties", &open, ImGuiWindowFlags_None);
 
+  // the edits are recorded while the panel is in use, so a slider drag or a color pick becomes a single undo step
+  const bool inUse = ImGui::IsWindowHovered(ImGuiHoveredFlags_RootAndChildWindows | ImGuiHoveredFlags_AllowWhenBlockedByPopup) || 
+    ImGui::IsPopupOpen("", ImGuiPopupFlags_AnyPopupId | ImGuiPopupFlags_AnyPopupLevel);
+  if(m_modifying && !m_sheet->IsModifying()) // committed by the sheet, e.g. when the entity is deleted
+    m_modifying = false;
+
   auto selectedEntities = m_sheet->GetSelectedEntities();
   if(selectedEntities.size() != 0)
   {
     auto& entity = selectedEntities[0];
+    if(inUse && !m_sheet->IsModifying())
+    {
+      m_sheet->BeginModify(entity);
+      m_modifying = true;
+    }
     DrawAttibuteEdit(entity);
   } 
 
+  const bool editing = ImGui::IsAnyItemActive();
+  if(m_modifying && ((m_editing && !editing) || (!inUse && !editing) || selectedEntities.empty()))
+  {
+    m_sheet->CommitModify();
+    m_modifying = false;
+  }
+  m_editing = editing;
+
   ImGui::End();
 }
 template<typename T, typename UIFunction>
@@ -45,9 +64,15 @@ void AttributeEditor::DrawAttibuteEdit(Entity entity)
 {
   if(ImGui::Button("Delete"))
   {
-    Entity::DestroyEntity(entity);
+    m_sheet->DeleteEntity(entity);
     return;
   }
+  ImGui::SameLine();
+  if(ImGui::Button("Bring to front"))
+    m_sheet->BringToFront(entity);
+  ImGui::SameLine();
+  if(ImGui::Button("Send to back"))
+    m_sheet->SendToBack(entity);
   DrawComponent<ColorComponent>("Color", entity, [&](auto& component)
   {
     static ImVec4 backup_color;
@@ -115,7 +140,9 @@ void AttributeEditor::DrawAttibuteEdit(Entity entity)
   DrawComponent<TextComponent>("Font size", entity, [&](auto& component)
   {
     ImGui::Text("FontSize");
-    ImGui::SliderInt("##F", &(component.fontSize), 1, 10, "%d");
+    // the box follows the size of the text, the layout is rebuilt with the new size
+    if(ImGui::SliderInt("##F", &(component.fontSize), 1, 10, "%d"))
+      TextComponentWrapper(entity).UpdateShapeAttributes();
   });
 
   DrawComponent<SkinTemplateComponent>("Skin template params", entity, [&](auto& component)
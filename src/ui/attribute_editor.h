@@ -17,6 +17,8 @@ private:
 
 private:
   DrawingSheet* m_sheet;  // TODO: have a shared_ptr or something??
+  bool m_modifying = false; // the panel has an open step in the sheet's history
+  bool m_editing = false;
 };
 
 } // namespace medicimage
@@ -1,8 +1,11 @@
 #include "ui/editor_ui.h"
 #include "core/log.h"
+#include "image_handling/glyph_atlas.h"
 
 #include "widgets/ImFileDialog.h"
 #include <assert.h>
+#include <iomanip>
+#include <sstream>
 
 namespace medicimage
 {
@@ -20,6 +23,7 @@ EditorUI::~EditorUI()
 
 void EditorUI::OnUpdate()
 {
+  SaveProcessedStill();
   if(m_editorState == EditorState::SCREENSHOT)
   {
     if(m_timer.Done())
@@ -29,11 +33,14 @@ void EditorUI::OnUpdate()
   }
   else if(m_editorState == EditorState::SHOW_CAMERA)
   {
-    // load a frame from the camera
-    auto frame = std::move(m_camera.CaptureFrame());
-    if (frame)
-      m_frame = std::move(frame.value());
-    frame.reset();
+    // upload the newest preview frame from the camera, the texture is reused while the size does not change
+    m_cameras.GetPrimary().UpdatePreview(m_frame);
+    // the secondary cameras are updated independently, a camera without a new frame keeps showing its last one
+    auto secondaries = m_cameras.GetSecondaryCameras();
+    std::erase_if(m_pictureInPictureFrames, [&](const auto& entry)
+      { return std::find(secondaries.begin(), secondaries.end(), entry.first) == secondaries.end(); });
+    for(int index : secondaries)
+      m_cameras.GetCamera(index).UpdatePreview(m_pictureInPictureFrames[index]);
   }
 }
 
@@ -74,8 +81,13 @@ void EditorUI::OnAttach()
   
   // initieliaze the frames 
   m_frame = std::make_unique<Texture2D>("initial checkerboard", "assets/textures/Checkerboard.png"); // initialize the edited frame with the current frame and later update only the current frame in OnUpdate
-  m_camera.Init();
-  m_camera.Open(0);
+  m_cameras.Init();
+  m_cameras.SetCalibrationFolder(m_appConfig.GetAppFolder() / "calibration");
+  m_cameras.SetPrimaryRawFrameCallback([this](const cv::Mat& frame){ m_recorder.PushFrame(frame); });
+  if(m_cameras.GetNumberOfDevices() > 0)
+    m_cameras.Open(0);
+  OnPrimaryCameraChanged();
+  m_cameras.StartHotPlugMonitor();
   
   // init file dialog
   ifd::FileDialog::Instance().CreateTexture = [&](uint8_t* data, int w, int h, char fmt) -> void*
@@ -95,7 +107,8 @@ void EditorUI::OnAttach()
   // load the bigger font and the smaller font for restoring
   ImGuiIO& io = ImGui::GetIO(); 
   m_smallFont = io.Fonts->AddFontFromFileTTF("assets/fonts/calibri/calibri_regular.ttf", 18.0);
-  m_largeFont = io.Fonts->AddFontFromFileTTF("assets/fonts/calibri/calibri_regular.ttf", 48.0);
+  // the text being typed is shown with this font, so it covers the same characters as the committed text
+  m_largeFont = io.Fonts->AddFontFromFileTTF("assets/fonts/calibri/calibri_regular.ttf", 48.0, nullptr, GlyphAtlas::GetGlyphRanges());
   ImGuiStyle& style = ImGui::GetStyle();
   s_defaultFrameBgColor = style.Colors[ImGuiCol_Button];
 } 
@@ -107,6 +120,9 @@ void EditorUI::OnEvent(Event* event)
   EventDispatcher dispatcher(event);
   dispatcher.Dispatch<KeyTextInputEvent>(BIND_EVENT_FN(EditorUI::OnKeyTextInputEvent));
   dispatcher.Dispatch<KeyPressedEvent>(BIND_EVENT_FN(EditorUI::OnKeyPressedEvent));
+  dispatcher.Dispatch<MouseMovedEvent>(BIND_EVENT_FN(EditorUI::OnMouseMovedEvent));
+  dispatcher.Dispatch<MouseButtonPressedEvent>(BIND_EVENT_FN(EditorUI::OnMouseButtonPressedEvent));
+  dispatcher.Dispatch<MouseButtonReleasedEvent>(BIND_EVENT_FN(EditorUI::OnMouseButtonReleasedEvent));
 }
 
 bool EditorUI::OnKeyTextInputEvent(KeyTextInputEvent* e)
@@ -122,15 +138,73 @@ bool EditorUI::OnKeyPressedEvent(KeyPressedEvent* e)
 {
   if(m_editorState == EditorState::EDITING)
   {
-    m_drawingSheet.OnKeyPressed(e->GetKeyCode());
+    // ctrl+z/ctrl+y go to the history, the text input still gets the letters through the text input events
+    const bool ctrl = ImGui::GetIO().KeyCtrl;
+    if(ctrl && e->GetKeyCode() == Key::MDIK_z)
+      m_drawingSheet.Undo();
+    else if(ctrl && e->GetKeyCode() == Key::MDIK_y)
+      m_drawingSheet.Redo();
+    else
+      m_drawingSheet.OnKeyPressed(e->GetKeyCode());
   }
   return true;
 }
 static ImVec2 mousePos;
 static ImVec2 viewportOffset;
 static ImVec2 mousePosOnImage;
+static ImVec2 imageOrigin; // top left corner of the shown image, from the last frame
+static bool imageHovered = false; // from the last frame as well, so the windows over the image get their clicks
+static bool imagePressed = false; // the click started on the image, its release goes to the sheet wherever it is
 static glm::vec2 drawingSheetSize;
 static ImVec2 imageSize;
+
+bool EditorUI::OnMouseMovedEvent(MouseMovedEvent* e)
+{
+  // the events are polled before the frame, so the image is where it was shown the last time
+  if(m_editorState == EditorState::EDITING)
+    m_drawingSheet.OnMouseMoved({e->GetX() - imageOrigin.x, e->GetY() - imageOrigin.y});
+  return true;
+}
+
+bool EditorUI::OnMouseButtonPressedEvent(MouseButtonPressedEvent* e)
+{
+  // the press and the release come in the order they happened, even if both are within one frame
+  if(m_editorState == EditorState::EDITING && e->GetMouseButton() == Mouse::ButtonLeft && imageHovered)
+  {
+    imagePressed = true;
+    m_drawingSheet.OnMouseButtonPressed({e->GetX() - imageOrigin.x, e->GetY() - imageOrigin.y});
+  }
+  return true;
+}
+
+bool EditorUI::OnMouseButtonReleasedEvent(MouseButtonReleasedEvent* e)
+{
+  if(e->GetMouseButton() != Mouse::ButtonLeft || !imagePressed)
+    return true;
+  imagePressed = false;
+  if(m_editorState == EditorState::EDITING)
+    m_drawingSheet.OnMouseButtonReleased({e->GetX() - imageOrigin.x, e->GetY() - imageOrigin.y});
+  return true;
+}
+
+void EditorUI::ShowTextOverlay(const TextOverlay& overlay)
+{
+  // drawn with the same font as the glyph atlas, scaled like the shown image, so the committed text lands at the same place
+  const ImVec2 imageMin = ImGui::GetItemRectMin();
+  const float fontSize = GlyphAtlas::GetPixelSize(overlay.fontSize) * imageSize.x / static_cast<float>(m_frame->GetWidth());
+  const float scale = fontSize / m_largeFont->FontSize;
+  const ImVec2 baseline{imageMin.x + overlay.position.x * imageSize.x, imageMin.y + overlay.position.y * imageSize.y};
+  const ImVec2 topLeft{baseline.x, baseline.y - m_largeFont->Ascent * scale};
+  const float bottom = baseline.y - m_largeFont->Descent * scale;
+  const float textWidth = m_largeFont->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, overlay.text.c_str()).x;
+
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  drawList->AddRectFilled(topLeft, ImVec2{baseline.x + textWidth, bottom}, IM_COL32_WHITE);
+  drawList->AddText(m_largeFont, fontSize, topLeft, IM_COL32_BLACK, overlay.text.c_str());
+  if(overlay.caretVisible)
+    drawList->AddLine(ImVec2{baseline.x + textWidth, topLeft.y}, ImVec2{baseline.x + textWidth, bottom}, IM_COL32_BLACK, std::max(1.0f, fontSize / 16.0f));
+}
+
 void EditorUI::ShowImageWindow()
 {
   // Main window containing the stream and uuid input
@@ -155,24 +229,25 @@ void EditorUI::ShowImageWindow()
     drawingSheetSize = {viewportMaxRegion.x - viewportMinRegion.x, viewportMaxRegion.y - viewportMinRegion.y};
     ImGui::Image(m_frame->GetShaderResourceView(), imageSize, uvMin, uvMax, tintColor, borderColor);
     m_drawingSheet.SetDrawingSheetSize({ imageSize.x, imageSize.y });
+    if(auto overlay = m_drawingSheet.GetTextOverlay())
+    {
+      // clicking on an other window commits the text, like the Enter
+      if(!ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows))
+        m_drawingSheet.OnFocusLost();
+      else
+        ShowTextOverlay(overlay.value());
+    }
     
     mousePos = ImGui::GetMousePos();
     viewportOffset = ImGui::GetWindowPos();
-    mousePosOnImage = { mousePos.x - viewportOffset.x - viewportMinRegion.x, mousePos.y - viewportOffset.y - viewportMinRegion.y };
-    if(ImGui::IsItemHovered())
+    imageOrigin = { viewportOffset.x + viewportMinRegion.x, viewportOffset.y + viewportMinRegion.y };
+    mousePosOnImage = { mousePos.x - imageOrigin.x, mousePos.y - imageOrigin.y };
+    // the clicks come from the mouse button events, the dragging and the hovering are updated once per frame
+    imageHovered = ImGui::IsItemHovered();
+    if(imageHovered)
     {
-      if(ImGui::IsMouseClicked(ImGuiMouseButton_Left))
-      {
-        m_drawingSheet.OnMouseButtonPressed({mousePosOnImage.x, mousePosOnImage.y});
-      }
-      else if(ImGui::IsMouseDown(ImGuiMouseButton_Left))
-      {
+      if(imagePressed && ImGui::IsMouseDown(ImGuiMouseButton_Left))
         m_drawingSheet.OnMouseButtonDown({mousePosOnImage.x, mousePosOnImage.y});
-      }
-      else if(ImGui::IsMouseReleased(ImGuiMouseButton_Left))
-      {
-        m_drawingSheet.OnMouseButtonReleased({mousePosOnImage.x, mousePosOnImage.y});
-      }
       else
         m_drawingSheet.OnMouseHovered({mousePosOnImage.x, mousePosOnImage.y});
     }
@@ -181,7 +256,25 @@ void EditorUI::ShowImageWindow()
   }
   else
   { // just show the frame from the camera
+    imageHovered = false;
+    m_cameras.GetPrimary().SetPreviewSize(static_cast<int>(canvasSize.x), static_cast<int>(canvasSize.y));
     ImGui::Image(m_frame->GetShaderResourceView(), canvasSize, uvMin, uvMax, tintColor, borderColor);
+    if(m_showPictureInPicture)
+      ShowPictureInPicture();
+    if(m_cameras.GetPrimary().IsConnectionLost())
+    {
+      constexpr const char* disconnectedText = "Camera disconnected, waiting for it to be plugged in again";
+      ImVec2 imageMin = ImGui::GetItemRectMin();
+      ImVec2 textSize = ImGui::CalcTextSize(disconnectedText);
+      ImVec2 textPos{imageMin.x + (canvasSize.x - textSize.x) / 2.0f, imageMin.y + (canvasSize.y - textSize.y) / 2.0f};
+      ImDrawList* drawList = ImGui::GetWindowDrawList();
+      drawList->AddRectFilled(ImVec2{textPos.x - 8.0f, textPos.y - 4.0f}, ImVec2{textPos.x + textSize.x + 8.0f, textPos.y + textSize.y + 4.0f}, IM_COL32(0, 0, 0, 180));
+      drawList->AddText(textPos, IM_COL32(255, 80, 80, 255), disconnectedText);
+    }
+    if(m_editorState == EditorState::SHOW_CAMERA)
+      m_shownFrameTimestamps = m_frame->GetFrameTimestamps();
+    if(m_showLatencyOverlay)
+      ShowCameraLatencyOverlay();
   }
   ImGui::End();
   
@@ -258,6 +351,210 @@ void EditorUI::ShowImageWindow()
 
 }
 
+void EditorUI::ShowCameraLatencyOverlay()
+{
+  const auto& endToEnd = m_latencyStats.GetHistogram(CameraLatencyStats::Stage::CAPTURE_TO_PRESENT);
+  char overlayText[128];
+  snprintf(overlayText, sizeof(overlayText), "latency p50: %.1f ms p99: %.1f ms dropped: %llu late: %llu", 
+    endToEnd.GetPercentileMs(50.0), endToEnd.GetPercentileMs(99.0), 
+    static_cast<unsigned long long>(m_latencyStats.GetDroppedFrames()), static_cast<unsigned long long>(m_latencyStats.GetLateFrames()));
+
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  ImVec2 imageTopLeft = ImGui::GetItemRectMin();
+  ImVec2 textPos{imageTopLeft.x + 8.0f, imageTopLeft.y + 8.0f};
+  ImVec2 textSize = ImGui::CalcTextSize(overlayText);
+  drawList->AddRectFilled(ImVec2{textPos.x - 4.0f, textPos.y - 2.0f}, ImVec2{textPos.x + textSize.x + 4.0f, textPos.y + textSize.y + 2.0f}, IM_COL32(0, 0, 0, 160));
+  drawList->AddText(textPos, IM_COL32(255, 255, 0, 255), overlayText);
+}
+
+void EditorUI::ShowCameraLatencyStats()
+{
+  ImGui::Separator();
+  ImGui::Text("Camera frames presented:%llu dropped:%llu late:%llu", static_cast<unsigned long long>(m_latencyStats.GetPresentedFrames()),
+    static_cast<unsigned long long>(m_latencyStats.GetDroppedFrames()), static_cast<unsigned long long>(m_latencyStats.GetLateFrames()));
+  for(int i = 0; i < static_cast<int>(CameraLatencyStats::Stage::COUNT); i++)
+  {
+    auto stage = static_cast<CameraLatencyStats::Stage>(i);
+    const auto& histogram = m_latencyStats.GetHistogram(stage);
+    ImGui::Text("%s p50:%.2f ms p99:%.2f ms max:%.2f ms", CameraLatencyStats::GetStageName(stage), 
+      histogram.GetPercentileMs(50.0), histogram.GetPercentileMs(99.0), histogram.GetMaxMs());
+  }
+  ImGui::Checkbox("Latency overlay", &m_showLatencyOverlay);
+  ImGui::SameLine();
+  if(ImGui::Button("Export latency stats"))
+    m_latencyStats.ExportJson(m_appConfig.GetAppFolder() / "camera_latency.json");
+  ImGui::SameLine();
+  if(ImGui::Button("Reset latency stats"))
+    m_latencyStats.Reset();
+}
+
+void EditorUI::ShowRecorderStats()
+{
+  ImGui::Separator();
+  auto stats = m_recorder.GetStats();
+  ImGui::Text("Recording:%s encode:%.1f fps queue:%zu/%zu encoded:%llu dropped:%llu", m_recorder.IsRecording() ? "on" : "off",
+    stats.encodeFps, stats.queueDepth, stats.queueCapacity, static_cast<unsigned long long>(stats.encodedFrames),
+    static_cast<unsigned long long>(stats.droppedFrames));
+  auto dropPolicy = m_recorder.GetDropPolicy();
+  if(ImGui::BeginCombo("Recorder drop policy", VideoRecorder::GetDropPolicyName(dropPolicy)))
+  {
+    for(auto policy : {VideoRecorder::DropPolicy::DROP_OLDEST, VideoRecorder::DropPolicy::DROP_NEWEST})
+    {
+      if(ImGui::Selectable(VideoRecorder::GetDropPolicyName(policy), policy == dropPolicy))
+        m_recorder.SetDropPolicy(policy);
+    }
+    ImGui::EndCombo();
+  }
+}
+
+void EditorUI::OnPrimaryCameraChanged()
+{
+  // the recorded frames would change their size in the middle of the video
+  if(m_recorder.IsRecording())
+  {
+    APP_CORE_WARN("Primary camera changed, recording stopped");
+    m_recorder.Stop();
+  }
+  m_latencyStats.Reset();
+  m_latencyStats.SetFrameBudget(std::chrono::duration_cast<FrameClock::duration>(std::chrono::duration<double>(2.0 / m_cameras.GetPrimary().GetFrameRate())));
+}
+
+void EditorUI::ShowPictureInPicture()
+{
+  // the secondary feeds are stacked up from the bottom right corner of the primary one
+  constexpr float margin = 8.0f;
+  const ImVec2 imageMin = ImGui::GetItemRectMin();
+  const ImVec2 imageMax = ImGui::GetItemRectMax();
+  const ImVec2 pipSize{(imageMax.x - imageMin.x) * s_pictureInPictureScale, (imageMax.y - imageMin.y) * s_pictureInPictureScale};
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  float bottom = imageMax.y - margin;
+  for(int index : m_cameras.GetSecondaryCameras())
+  {
+    // the capture thread of the secondary camera downscales only to the picture-in-picture size
+    m_cameras.GetCamera(index).SetPreviewSize(static_cast<int>(pipSize.x), static_cast<int>(pipSize.y));
+    auto it = m_pictureInPictureFrames.find(index);
+    if(it == m_pictureInPictureFrames.end() || it->second == nullptr)
+      continue;
+    ImVec2 pipMin{imageMax.x - margin - pipSize.x, bottom - pipSize.y};
+    ImVec2 pipMax{imageMax.x - margin, bottom};
+    drawList->AddImage(it->second->GetShaderResourceView(), pipMin, pipMax);
+    drawList->AddRect(pipMin, pipMax, IM_COL32(255, 255, 255, 255), 0.0f, 0, 2.0f);
+    bottom -= pipSize.y + margin;
+  }
+}
+
+void EditorUI::ShowLensCorrectionStats()
+{
+  ImGui::Separator();
+  auto& undistortion = m_cameras.GetPrimary().GetUndistortion();
+  {
+    GuiDisableGuard guard(!undistortion.HasCalibration());
+    bool enabled = undistortion.IsEnabled();
+    if(ImGui::Checkbox("Lens correction", &enabled))
+      undistortion.SetEnabled(enabled);
+  }
+  if(!undistortion.HasCalibration())
+  {
+    ImGui::SameLine();
+    ImGui::TextDisabled("(no calibration for this camera)");
+    return;
+  }
+  auto timing = undistortion.GetTiming();
+  ImVec4 timingColor = timing.GetPercentileMs(99.0) > Undistortion::s_budgetMs ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+  ImGui::TextColored(timingColor, "Lens correction p50:%.2f ms p99:%.2f ms max:%.2f ms (budget:%.1f ms)", timing.GetPercentileMs(50.0),
+    timing.GetPercentileMs(99.0), timing.GetMaxMs(), Undistortion::s_budgetMs);
+  ImGui::SameLine();
+  if(ImGui::Button("Reset lens correction timing"))
+    undistortion.ResetTiming();
+}
+
+void EditorUI::ToggleRecording()
+{
+  if(m_recorder.IsRecording())
+  {
+    m_recorder.Stop();
+    return;
+  }
+
+  if(!m_imageSavers->HasSelectedSaver())
+  {
+    APP_CORE_ERR("Please input valid UUID for recording a video!");
+    return;
+  }
+  auto& saver = m_imageSavers->GetSelectedSaver();
+  std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::stringstream ss;
+  ss << saver.GetUuid() << "_" << std::put_time(std::localtime(&now), "%Y%m%d_%H%M%S") << ".avi";
+  m_recorder.Start(saver.GetPatientFolder() / ss.str(), m_cameras.GetPrimary().GetFrameRate());
+}
+
+void EditorUI::OnFramePresented()
+{
+  if(m_shownFrameTimestamps.has_value())
+    m_latencyStats.OnFramePresented(m_shownFrameTimestamps.value(), FrameClock::now());
+  m_shownFrameTimestamps.reset();
+}
+
+void EditorUI::CaptureStill()
+{
+  if(m_processedStill.valid())
+  {
+    APP_CORE_WARN("The previous still is still being processed, screenshot skipped");
+    return;
+  }
+
+  std::vector<cv::Mat> frames;
+  if(m_stillCaptureMode == StillCaptureMode::SINGLE_FRAME)
+  {
+    auto still = m_cameras.GetPrimary().GetLatestStill();
+    if(still.has_value())
+      frames.push_back(std::move(still.value()));
+  }
+  else
+    frames = m_cameras.GetPrimary().TakeRecentStills(m_burstFrameCount);
+
+  if(frames.empty())
+  { // the preview texture is only the fallback, when there is no full resolution camera frame
+    m_activeDocument = m_imageSavers->GetSelectedSaver().AddImage(*m_frame.get(), false);
+    return;
+  }
+
+  // the enhancement of the still runs on a copy of the live graph, so it does not share buffers with the capture thread
+  std::unique_ptr<ImagePipeline> enhancement;
+  if(m_imagePipelineEditor.ApplyOnStills() && m_cameras.GetPrimary().GetImagePipeline().HasEnabledStage())
+    enhancement = m_cameras.GetPrimary().GetImagePipeline().Clone();
+  m_processedStill = std::async(std::launch::async,
+    [frames = std::move(frames), mode = m_stillCaptureMode, enhancement = std::move(enhancement)]() mutable
+  {
+    cv::Mat still;
+    if(mode == StillCaptureMode::TEMPORAL_DENOISE)
+      still = StillProcessing::AverageAligned(frames);
+    else if(mode == StillCaptureMode::SHARPEST_FRAME)
+      still = std::move(frames[StillProcessing::SelectSharpest(frames)]);
+    else
+      still = std::move(frames.front());
+    if(enhancement != nullptr)
+      still = enhancement->Process(still);
+    return still;
+  });
+}
+
+void EditorUI::SaveProcessedStill()
+{
+  using namespace std::chrono_literals;
+  if(!m_processedStill.valid() || m_processedStill.wait_for(0ms) != std::future_status::ready)
+    return;
+  // adding a document invalidates m_activeDocument, so the still waits while a saved image is opened
+  if(m_editorState == EditorState::IMAGE_SELECTION || m_editorState == EditorState::EDITING)
+    return;
+
+  cv::Mat still = m_processedStill.get();
+  if(m_imageSavers->HasSelectedSaver())
+    m_imageSavers->GetSelectedSaver().AddImage(still);
+  else
+    APP_CORE_ERR("Please input valid UUID for saving the current image!");
+}
+
 void EditorUI::ShowToolbox()
 {
   ImGui::Begin("Tools", nullptr , ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoTitleBar);
@@ -283,7 +580,7 @@ void EditorUI::ShowToolbox()
         {
           if (m_imageSavers->HasSelectedSaver()) 
           { // create the ImageDocument here, because the screenshot is made here
-            m_activeDocument = m_imageSavers->GetSelectedSaver().AddImage(*m_frame.get(), false);
+            CaptureStill();
           }
           else
           {
@@ -296,6 +593,12 @@ void EditorUI::ShowToolbox()
     }
   }
 
+  {
+    GuiDisableGuard disableGuard(m_editorState != EditorState::SHOW_CAMERA && !m_recorder.IsRecording());
+    if(ImGui::Button(m_recorder.IsRecording() ? "Stop recording" : "Record video", ImVec2(bigIconWidth, 0.0f)))
+      ToggleRecording();
+  }
+
   {
     GuiDisableGuard disableGuard(m_editorState != EditorState::EDITING);
     if (ImGui::ImageButton("save", m_saveIcon->GetShaderResourceView(), smallIconSize, uvMin, uvMax, iconBg, tintColor))
@@ -303,8 +606,9 @@ void EditorUI::ShowToolbox()
       if(m_editorState == EditorState::EDITING)
       {
         if (m_imageSavers->HasSelectedSaver()) 
-        { 
-          m_imageSavers->GetSelectedSaver().AddImage(*m_frame.get(), true);
+        { // the annotations are saved with the clean frame, so the new document can be edited again
+          auto annotations = m_drawingSheet.SaveAnnotations();
+          m_imageSavers->GetSelectedSaver().AddImage(*m_frame.get(), *m_drawingSheet.GetDocument().texture, std::move(annotations));
         }
         else
           APP_CORE_ERR("Please input valid UUID for saving the current image!");
@@ -360,8 +664,12 @@ void EditorUI::ShowToolbox()
     GuiDisableGuard disableGuard(m_editorState == EditorState::SHOW_CAMERA || m_editorState == EditorState::SCREENSHOT);
     if (ImGui::ImageButton("undo", m_undoIcon->GetShaderResourceView(), smallIconSize, uvMin, uvMax, iconBg, tintColor))
     {
-      if(m_editorState == EditorState::EDITING || m_editorState == EditorState::IMAGE_SELECTION)
+      if(m_editorState == EditorState::EDITING && m_drawingSheet.CanUndo())
       {
+        m_drawingSheet.Undo();
+      }
+      else if(m_editorState == EditorState::EDITING || m_editorState == EditorState::IMAGE_SELECTION)
+      { // nothing to undo on the sheet, the undo goes back to the camera
         if(m_drawingSheet.HasAnnotated())
         {
           ImGui::OpenPopup("undo");
@@ -377,6 +685,14 @@ void EditorUI::ShowToolbox()
     }
   }
 
+  ImGui::SameLine();
+  {
+    GuiDisableGuard disableGuard(m_editorState != EditorState::EDITING || !m_drawingSheet.CanRedo());
+    // the redo icon is the undo arrow mirrored
+    if (ImGui::ImageButton("redo", m_undoIcon->GetShaderResourceView(), smallIconSize, ImVec2(uvMax.x, uvMin.y), ImVec2(uvMin.x, uvMax.y), iconBg, tintColor))
+      m_drawingSheet.Redo();
+  }
+
   ImGui::SameLine();
   
   if(m_editorState == EditorState::EDITING || m_editorState == EditorState::IMAGE_SELECTION)
@@ -430,6 +746,8 @@ void EditorUI::ShowToolbox()
     drawDrawingTool("rectangle", m_rectangleIcon.get(), DrawCommand::DRAW_RECTANGLE);
     ImGui::SameLine();
     drawDrawingTool("arrow", m_arrowIcon.get(), DrawCommand::DRAW_ARROW);
+    drawDrawingTool("freehand", m_pencilIcon.get(), DrawCommand::DRAW_FREEHAND);
+    ImGui::SameLine();
     drawDrawingTool("skin-template", m_skinTemplateIcon.get(), DrawCommand::DRAW_SKIN_TEMPLATE);
     ImGui::SameLine();
   }
@@ -489,8 +807,10 @@ void EditorUI::ShowThumbnails()
       ImGui::Text("%s", it->documentId.c_str());
       ImVec2 pos = ImGui::GetCursorScreenPos();
       ImVec2 canvasSize = ImGui::GetContentRegionAvail();
-      float aspectRatio = static_cast<float>(m_frame->GetWidth()) / static_cast<float>(m_frame->GetHeight());
-      if(ImGui::ImageButton(it->documentId.c_str(), it->texture->GetShaderResourceView(), ImVec2{canvasSize.x, canvasSize.x / aspectRatio}, uvMin, uvMax, backgroundColor, tintColor))
+      // the annotated documents are shown by their thumbnails, their texture is the clean frame
+      Texture2D* thumbnail = it->thumbnail != nullptr ? it->thumbnail.get() : it->texture.get();
+      float aspectRatio = static_cast<float>(thumbnail->GetWidth()) / static_cast<float>(thumbnail->GetHeight());
+      if(ImGui::ImageButton(it->documentId.c_str(), thumbnail->GetShaderResourceView(), ImVec2{canvasSize.x, canvasSize.x / aspectRatio}, uvMin, uvMax, backgroundColor, tintColor))
       {
         if(m_editorState == EditorState::SHOW_CAMERA || m_editorState == EditorState::IMAGE_SELECTION)
         {
@@ -498,7 +818,7 @@ void EditorUI::ShowThumbnails()
           m_activeDocument = it;
           m_drawingSheet.StartAnnotation();
           m_drawingSheet.SetDocument(std::move(std::make_unique<ImageDocument>(*it)), {it->texture->GetWidth(), it->texture->GetHeight()});  // BIG TODO: update store the image size somewhere 
-          m_drawingSheet.ChangeDrawState(std::make_unique<BaseDrawState>(&m_drawingSheet));
+          m_drawingSheet.ChangeDrawState<BaseDrawState>();
         }
       }
 
@@ -584,22 +904,53 @@ void EditorUI::OnImguiRender()
         }
         ImGui::EndMenu();
       }
+      if(ImGui::BeginMenu("Capture"))
+      {
+        if(ImGui::RadioButton("Single frame", m_stillCaptureMode == StillCaptureMode::SINGLE_FRAME))
+          m_stillCaptureMode = StillCaptureMode::SINGLE_FRAME;
+        if(ImGui::RadioButton("Sharpest of burst", m_stillCaptureMode == StillCaptureMode::SHARPEST_FRAME))
+          m_stillCaptureMode = StillCaptureMode::SHARPEST_FRAME;
+        if(ImGui::RadioButton("Temporal denoise", m_stillCaptureMode == StillCaptureMode::TEMPORAL_DENOISE))
+          m_stillCaptureMode = StillCaptureMode::TEMPORAL_DENOISE;
+        {
+          GuiDisableGuard guard(m_stillCaptureMode == StillCaptureMode::SINGLE_FRAME);
+          // one slot of the ring buffer is always under writing
+          const int maxBurstFrames = static_cast<int>(m_cameras.GetPrimary().GetStillBufferCapacity()) - 1;
+          ImGui::SliderInt("Burst frames", &m_burstFrameCount, 2, maxBurstFrames);
+        }
+        ImGui::EndMenu();
+      }
       if(ImGui::BeginMenu("Camera selection"))
       {
-        for(int i = 0; i < m_camera.GetNumberOfDevices(); i++)
+        for(int i = 0; i < m_cameras.GetNumberOfDevices(); i++)
         {
-          std::string cameraName = m_camera.GetDeviceName(i); 
+          auto cameraName = m_cameras.GetDeviceName(i);
+          if(m_cameras.GetCamera(i).IsConnectionLost())
+            cameraName += " (disconnected)";
+          ImGui::PushID(i);
+          bool opened = m_cameras.IsOpened(i);
+          if(ImGui::Checkbox(cameraName.c_str(), &opened))
+          {
+            auto primary = m_cameras.GetPrimaryIndex();
+            if(opened)
+              m_cameras.Open(i);
+            else
+              m_cameras.Close(i);
+            if(primary != m_cameras.GetPrimaryIndex())
+              OnPrimaryCameraChanged();
+          }
+          ImGui::SameLine();
           {
-            const auto cameraName = m_camera.GetDeviceName(i);
-            auto selectedDevice = m_camera.GetSelectedDevices();
-            GuiDisableGuard guard(selectedDevice.has_value() && (selectedDevice.value() == i));
-            if(ImGui::Button(cameraName.c_str()))
+            GuiDisableGuard guard(!m_cameras.IsOpened(i));
+            if(ImGui::RadioButton("primary", m_cameras.GetPrimaryIndex() == i) && m_cameras.GetPrimaryIndex() != i)
             {
-              m_camera.Open(i);
-              break;
+              m_cameras.SetPrimary(i);
+              OnPrimaryCameraChanged();
             }
           }
+          ImGui::PopID();
         }
+        ImGui::Checkbox("Picture in picture", &m_showPictureInPicture);
         ImGui::EndMenu();
       }
       ImGui::EndMenu();
@@ -616,6 +967,7 @@ void EditorUI::OnImguiRender()
       // when setting a new application folder, the thumbnails and the image savers should be reset(the data will remain in the data folder)
 		  m_appConfig.UpdateAppFolder(result);
       m_imageSavers = std::move(std::make_unique<ImageSaverContainer>(m_appConfig.GetAppFolder()));
+      m_cameras.SetCalibrationFolder(m_appConfig.GetAppFolder() / "calibration");
       APP_CORE_INFO("Directory:{} selected", result.string());
 		}
 		ifd::FileDialog::Instance().Close();
@@ -625,12 +977,12 @@ void EditorUI::OnImguiRender()
   ShowToolbox();
   ShowThumbnails();
   m_attributeEditor.OnImguiRender(); 
+  m_imagePipelineEditor.OnImguiRender(m_cameras.GetPrimary().GetImagePipeline());
 
   // some profiling and debug info 
   ImGui::Begin("Profiling");
   ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-  auto state = m_drawingSheet.GetDrawState()->GetName();
-  ImGui::Text("Draw state:%s", state.c_str());
+  ImGui::Text("Draw state:%s", m_drawingSheet.GetDrawStateName());
   ImGui::SameLine();
   ImGui::Text("Draw command:%s", m_drawingSheet.GetDrawCommandName().c_str());
   ImGui::SameLine();
@@ -650,6 +1002,9 @@ void EditorUI::OnImguiRender()
   ImGui::Text("frame size:%d:%d", m_frame->GetWidth(), m_frame->GetHeight());
   ImGui::SameLine();
   ImGui::Text("ImageSize: %.2f:%.2f", imageSize.x, imageSize.y);
+  ShowCameraLatencyStats();
+  ShowRecorderStats();
+  ShowLensCorrectionStats();
   ImGui::End();
 } 
 
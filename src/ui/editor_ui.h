@@ -3,17 +3,23 @@
 #include "core/layer.h"
 #include "renderer/texture.h"
 #include "image_handling/image_editor.h"
-#include "camera/opencv_camera.h"
+#include "camera/camera_manager.h"
+#include "camera/still_processing.h"
+#include "camera/video_recorder.h"
 #include "image_handling/image_saver.h"
 #include "core/log.h"
 #include "core/utils.h"
 #include "input/key_event.h"
+#include "input/mouse_event.h"
 #include "drawing/drawing_sheet.h"
 #include "ui/attribute_editor.h"
+#include "ui/image_pipeline_editor.h"
 
 #include "imgui.h"
 #include <array>
+#include <future>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace medicimage
@@ -32,12 +38,26 @@ public:
   void OnDetach() override;
   void OnEvent(Event* event) override;
   void OnImguiRender() override;
+  void OnFramePresented(); // called after the swapchain present, closes the latency measurement of the shown camera frame
 private:
   bool OnKeyTextInputEvent(KeyTextInputEvent* e);
   bool OnKeyPressedEvent(KeyPressedEvent* e);
+  bool OnMouseMovedEvent(MouseMovedEvent* e);
+  bool OnMouseButtonPressedEvent(MouseButtonPressedEvent* e);
+  bool OnMouseButtonReleasedEvent(MouseButtonReleasedEvent* e);
   void ShowImageWindow();
+  void ShowTextOverlay(const TextOverlay& overlay);
   void ShowToolbox();
   void ShowThumbnails();
+  void ShowCameraLatencyOverlay();
+  void ShowCameraLatencyStats();
+  void CaptureStill();
+  void ToggleRecording();
+  void OnPrimaryCameraChanged();
+  void ShowPictureInPicture();
+  void ShowRecorderStats();
+  void ShowLensCorrectionStats();
+  void SaveProcessedStill();
   struct CallbackFunctions // for ImGui textinput callback 
   {
     static int EnterPressedCallback(ImGuiInputTextCallbackData* data)
@@ -63,12 +83,25 @@ private:
 
   std::vector<ImageDocument>::const_iterator m_activeDocument;
   std::unique_ptr<Texture2D> m_frame;
-  OpenCvCamera m_camera;
+  VideoRecorder m_recorder; // declared before the cameras, so the capture threads are stopped before the recorder is destroyed
+  CameraManager m_cameras;
+  std::unordered_map<int, std::unique_ptr<Texture2D>> m_pictureInPictureFrames; // preview of the secondary cameras
+  bool m_showPictureInPicture = true;
+  static constexpr float s_pictureInPictureScale = 0.25f;
+  CameraLatencyStats m_latencyStats;
+  std::optional<FrameTimestamps> m_shownFrameTimestamps;
+  bool m_showLatencyOverlay = false;
+  // burst capture: the last frames are processed into one still on a worker thread and saved when it is ready
+  enum class StillCaptureMode{SINGLE_FRAME, SHARPEST_FRAME, TEMPORAL_DENOISE};
+  StillCaptureMode m_stillCaptureMode = StillCaptureMode::SHARPEST_FRAME;
+  int m_burstFrameCount = 5;
+  std::future<cv::Mat> m_processedStill;
    
   // UI editor state specific members
   ImageEditor m_imageEditor; 
   DrawingSheet m_drawingSheet;
   AttributeEditor m_attributeEditor;   
+  ImagePipelineEditor m_imagePipelineEditor;
 
   EditorState m_editorState = EditorState::SHOW_CAMERA;
   Timer m_timer;
@@ -0,0 +1,75 @@
+#include "ui/image_pipeline_editor.h"
+
+#include "imgui.h"
+
+namespace medicimage
+{
+
+template<typename StageType, typename UIFunction>
+static void DrawStage(ImagePipeline& pipeline, UIFunction uiFunction)
+{
+  auto* stage = pipeline.GetStage<StageType>();
+  if(stage == nullptr)
+    return;
+
+  ImGui::Separator();
+  ImGui::PushID(stage->GetName().c_str());
+  bool enabled = stage->IsEnabled();
+  if(ImGui::Checkbox(stage->GetName().c_str(), &enabled))
+    stage->SetEnabled(enabled);
+  ImGui::SameLine();
+  if(enabled)
+    ImGui::Text("%.2f ms", stage->GetAverageMs());
+  else
+    ImGui::TextDisabled("bypassed");
+
+  // the parameters are edited on a copy and set back only when they changed
+  auto params = stage->GetParams();
+  if(uiFunction(params))
+    stage->SetParams(params);
+  ImGui::PopID();
+}
+
+void ImagePipelineEditor::OnImguiRender(ImagePipeline& pipeline)
+{
+  ImGui::Begin("Image enhancement");
+  ImGui::Checkbox("Apply on saved images", &m_applyOnStills);
+
+  DrawStage<WhiteBalanceStage>(pipeline, [](WhiteBalanceParams& params)
+  {
+    bool changed = ImGui::Checkbox("Automatic (gray world)", &params.automatic);
+    if(!params.automatic)
+    {
+      changed |= ImGui::SliderFloat("Red gain", &params.redGain, 0.25f, 4.0f);
+      changed |= ImGui::SliderFloat("Green gain", &params.greenGain, 0.25f, 4.0f);
+      changed |= ImGui::SliderFloat("Blue gain", &params.blueGain, 0.25f, 4.0f);
+    }
+    return changed;
+  });
+
+  DrawStage<GlareSuppressionStage>(pipeline, [](GlareSuppressionParams& params)
+  {
+    bool changed = ImGui::SliderInt("Brightness threshold", &params.threshold, 150, 255);
+    changed |= ImGui::SliderInt("Max saturation", &params.maxSaturation, 0, 255);
+    changed |= ImGui::SliderInt("Dilation", &params.dilation, 0, 10);
+    return changed;
+  });
+
+  DrawStage<ClaheStage>(pipeline, [](ClaheParams& params)
+  {
+    bool changed = ImGui::SliderFloat("Clip limit", &params.clipLimit, 0.5f, 10.0f);
+    changed |= ImGui::SliderInt("Tile grid size", &params.tileGridSize, 2, 16);
+    return changed;
+  });
+
+  DrawStage<SharpenStage>(pipeline, [](SharpenParams& params)
+  {
+    bool changed = ImGui::SliderFloat("Amount", &params.amount, 0.0f, 3.0f);
+    changed |= ImGui::SliderFloat("Sigma", &params.sigma, 0.5f, 5.0f);
+    return changed;
+  });
+
+  ImGui::End();
+}
+
+} // namespace medicimage
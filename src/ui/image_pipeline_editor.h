@@ -0,0 +1,19 @@
+#pragma once
+
+#include "camera/image_pipeline.h"
+
+namespace medicimage
+{
+
+class ImagePipelineEditor
+{
+public:
+  ImagePipelineEditor() = default;
+  void OnImguiRender(ImagePipeline& pipeline);
+  // the enhancement of the live feed is applied on the saved stills as well
+  bool ApplyOnStills() const {return m_applyOnStills;}
+private:
+  bool m_applyOnStills = false;
+};
+
+} // namespace medicimage